@@ -5,9 +5,48 @@
 
 #define JLIB_ARENA_HEADER_SIZE 128
 
+/*
+ * With a reserve_size the arena reserves that much contiguous address space up
+ * front and commits it ARENA_COMMIT_SIZE at a time as pos advances, so it never
+ * chains and arena_pos is a plain offset from the header. arena_pop_to gives
+ * back committed pages once ARENA_DECOMMIT_THRESHOLD of them sit past pos, but
+ * never below the size the arena was created with.
+ *
+ * Where the OS has no virtual memory calls reserve_size is ignored and the
+ * arena chains as usual.
+ */
+#ifndef ARENA_COMMIT_SIZE
+#define ARENA_COMMIT_SIZE KB(64)
+#endif
+
+#ifndef ARENA_DECOMMIT_THRESHOLD
+#define ARENA_DECOMMIT_THRESHOLD MB(1)
+#endif
+
+/* arena_push keeps Arena_stats on the arena it was called with, on by default in debug builds */
+#ifndef ARENA_STATS
+#ifdef DEBUG
+#define ARENA_STATS 1
+#else
+#define ARENA_STATS 0
+#endif
+#endif
+
+#define ARENA_REGISTRY_MAX 16
+
+typedef struct Arena_stats Arena_stats;
+struct Arena_stats {
+  u64 peak_pos;
+  u64 align_waste;    // bytes skipped to align pushes
+  u32 chain_count;    // blocks allocated to chain onto
+  u32 free_list_hits; // blocks reused from free_last
+  u32 commit_count;   // times a virtual arena committed more pages
+};
+
 typedef struct Arena_params Arena_params;
 struct Arena_params {
   u64 size;
+  u64 reserve_size;
   b32 cannot_chain;
   void *optional_backing_buffer;
 };
@@ -18,13 +57,15 @@ struct Arena {
   Arena *cur;
   b32 cannot_chain;
   b32 has_backing_buffer;
-  // TODO virtual memory
-  //u64 reserve_size; // virtual memory reserved
+  b32 is_virtual;
+  u64 reserve_size; // virtual memory reserved
+  u64 commit_floor; // committed memory pop_to keeps
   u64 size;  // actual memory committed
   u64 base_pos;
   u64 pos;
   u64 free_size;
   Arena *free_last;
+  Arena_stats stats;
 };
 
 STATIC_ASSERT(sizeof(Arena) <= JLIB_ARENA_HEADER_SIZE, arena_header_size_check);
@@ -35,6 +76,14 @@ struct Arena_scope {
   u64 pos;
 };
 
+/* named arenas for debug views to list, arena_free takes an arena out */
+typedef struct Arena_registry Arena_registry;
+struct Arena_registry {
+  Arena *arenas[ARENA_REGISTRY_MAX];
+  char  *names[ARENA_REGISTRY_MAX];
+  s32    count;
+};
+
 
 global read_only u64 ARENA_DEFAULT_SIZE = KB(64);
 
@@ -44,6 +93,7 @@ Arena* arena_alloc_(Arena_params *params);
 void arena_free(Arena *arena);
 
 void *arena_push(Arena *arena, u64 size, u64 align);
+b32   arena_grow_in_place(Arena *arena, void *ptr, u64 old_size, u64 new_size);
 u64   arena_pos(Arena *arena);
 void  arena_pop_to(Arena *arena, u64 pos);
 
@@ -53,6 +103,9 @@ void arena_pop(Arena *arena, u64 amount);
 Arena_scope scope_begin(Arena *arena);
 void scope_end(Arena_scope scope);
 
+void arena_register(Arena *arena, char *name);
+void arena_unregister(Arena *arena);
+
 #define push_array_no_zero_aligned(a, T, n, align) (T*)arena_push((a), sizeof(T)*(n), (align))
 #define push_array_aligned(a, T, n, align) (T*)memory_zero(push_array_no_zero_aligned(a, T, n, align), sizeof(T)*(n))
 #define push_array_no_zero(a, T, n) push_array_no_zero_aligned(a, T, n, MAX(8, align_of(T)))
@@ -73,16 +126,38 @@ void scope_end(Arena_scope scope);
 
 #include "os.h"
 
+#if defined(OS_LINUX) || defined(OS_MAC)
+#define JLIB_ARENA_VIRTUAL 1
+#else
+#define JLIB_ARENA_VIRTUAL 0
+#endif
+
+Arena_registry arena_registry;
+
 
 Arena* arena_alloc_(Arena_params *params) {
   u64 size = ALIGN_UP(params->size, align_of(void*));
+  u64 reserve_size = 0;
   b32 cannot_chain = params->cannot_chain;
   b32 has_backing_buffer = 0;
+  b32 is_virtual = 0;
   void *base = params->optional_backing_buffer;
 
   if(base) {
     cannot_chain = 1;
     has_backing_buffer = 1;
+  } else if(JLIB_ARENA_VIRTUAL && params->reserve_size > 0) {
+    size = ALIGN_UP(CLAMP_BOT(size, JLIB_ARENA_HEADER_SIZE), ARENA_COMMIT_SIZE);
+    reserve_size = ALIGN_UP(CLAMP_BOT(params->reserve_size, size), ARENA_COMMIT_SIZE);
+
+    base = os_reserve(reserve_size);
+    ASSERT(base);
+
+    b32 committed = os_commit(base, size);
+    ASSERT(committed);
+
+    cannot_chain = 1;
+    is_virtual = 1;
   } else {
     base = os_alloc(size);
     ASSERT(base);
@@ -93,11 +168,15 @@ Arena* arena_alloc_(Arena_params *params) {
   arena->prev = 0;
   arena->cannot_chain = cannot_chain;
   arena->has_backing_buffer = has_backing_buffer;
+  arena->is_virtual = is_virtual;
+  arena->reserve_size = reserve_size;
+  arena->commit_floor = size;
   arena->size = size;
   arena->base_pos = 0;
   arena->pos = JLIB_ARENA_HEADER_SIZE;
   arena->free_size = 0;
   arena->free_last = 0;
+  arena->stats = (Arena_stats){0};
 
   return arena;
 }
@@ -105,8 +184,15 @@ Arena* arena_alloc_(Arena_params *params) {
 void arena_free(Arena *arena) {
   ASSERT(arena);
 
+  arena_unregister(arena);
+
   if(arena->has_backing_buffer) return;
 
+  if(arena->is_virtual) {
+    os_release((void*)arena, arena->reserve_size);
+    return;
+  }
+
   for(Arena *a = arena->free_last, *prev = 0; a != 0; a = prev) {
     prev = a->prev;
     os_free((void*)a);
@@ -119,6 +205,23 @@ void arena_free(Arena *arena) {
 
 }
 
+force_inline void arena_commit_to(Arena *arena, u64 new_pos) {
+  Arena *cur = arena->cur;
+
+  ASSERT(cur->is_virtual);
+  ASSERT(new_pos <= cur->reserve_size);
+
+  u64 new_size = CLAMP_TOP(ALIGN_UP(new_pos, ARENA_COMMIT_SIZE), cur->reserve_size);
+  b32 committed = os_commit((u8*)cur + cur->size, new_size - cur->size);
+  ASSERT(committed);
+
+  cur->size = new_size;
+
+#if ARENA_STATS
+  arena->stats.commit_count++;
+#endif
+}
+
 void *arena_push(Arena *arena, u64 size, u64 align) {
   ASSERT(arena);
 
@@ -126,19 +229,25 @@ void *arena_push(Arena *arena, u64 size, u64 align) {
   u64 pos = ALIGN_UP(cur->pos, align);
   u64 new_pos = pos + size;
 
-  if(cur->size < new_pos && !cur->cannot_chain) {
+  if(cur->size < new_pos && cur->is_virtual) {
+    arena_commit_to(arena, new_pos);
+  } else if(cur->size < new_pos && !cur->cannot_chain) {
     Arena *new_arena = 0;
 
     Arena *prev_arena;
 
     for(new_arena = arena->free_last, prev_arena = 0; new_arena != 0; prev_arena = new_arena, new_arena = new_arena->prev) {
 
-      if(new_arena->size >= ALIGN_UP(size, align)) {
+      /* the block's own header sits in front of the push */
+      if(new_arena->size >= ALIGN_UP(JLIB_ARENA_HEADER_SIZE, align) + size) {
         if(prev_arena) {
           prev_arena->prev = new_arena->prev;
         } else {
           arena->free_last = new_arena->prev;
         }
+#if ARENA_STATS
+        arena->stats.free_list_hits++;
+#endif
         break;
       }
 
@@ -153,6 +262,9 @@ void *arena_push(Arena *arena, u64 size, u64 align) {
 
       Arena_params params = { .size = new_arena_size };
       new_arena = arena_alloc_(&params);
+#if ARENA_STATS
+      arena->stats.chain_count++;
+#endif
     }
 
     new_arena->base_pos = cur->base_pos + cur->size;
@@ -165,12 +277,48 @@ void *arena_push(Arena *arena, u64 size, u64 align) {
 
   }
 
+  ASSERT(new_pos <= cur->size);
+
+#if ARENA_STATS
+  arena->stats.align_waste += pos - cur->pos;
+  arena->stats.peak_pos = MAX(arena->stats.peak_pos, cur->base_pos + new_pos);
+#endif
+
   void *result = (u8*)cur + pos;
   cur->pos = new_pos;
 
   return result;
 }
 
+/*
+ * Extends ptr from old_size to new_size when it is the last push on the arena
+ * and the current block has room, or is virtual and can commit the room.
+ * Returns 0 and leaves the arena alone otherwise.
+ */
+b32 arena_grow_in_place(Arena *arena, void *ptr, u64 old_size, u64 new_size) {
+  ASSERT(arena);
+  ASSERT(new_size >= old_size);
+
+  Arena *cur = arena->cur;
+
+  if((u8*)ptr + old_size != (u8*)cur + cur->pos) return 0;
+
+  u64 new_pos = cur->pos + (new_size - old_size);
+
+  if(cur->size < new_pos) {
+    if(!cur->is_virtual || cur->reserve_size < new_pos) return 0;
+    arena_commit_to(arena, new_pos);
+  }
+
+  cur->pos = new_pos;
+
+#if ARENA_STATS
+  arena->stats.peak_pos = MAX(arena->stats.peak_pos, cur->base_pos + new_pos);
+#endif
+
+  return 1;
+}
+
 u64 arena_pos(Arena *arena) {
   ASSERT(arena);
 
@@ -185,6 +333,20 @@ void arena_pop_to(Arena *arena, u64 pos) {
   u64 big_pos = CLAMP_BOT(JLIB_ARENA_HEADER_SIZE, pos);
   Arena *cur = arena->cur;
 
+  if(cur->is_virtual) {
+    ASSERT(big_pos <= cur->pos);
+    cur->pos = big_pos;
+
+    u64 keep = CLAMP_BOT(ALIGN_UP(big_pos, ARENA_COMMIT_SIZE), cur->commit_floor);
+
+    if(cur->size >= keep + ARENA_DECOMMIT_THRESHOLD) {
+      os_decommit((u8*)cur + keep, cur->size - keep);
+      cur->size = keep;
+    }
+
+    return;
+  }
+
   for(Arena *prev = 0; cur->base_pos >= big_pos; cur = prev) {
     prev = cur->prev;
     cur->pos = JLIB_ARENA_HEADER_SIZE;
@@ -220,6 +382,32 @@ void scope_end(Arena_scope scope) {
   arena_pop_to(scope.arena, scope.pos);
 }
 
+void arena_register(Arena *arena, char *name) {
+  Arena_registry *registry = &arena_registry;
+
+  ASSERT(registry->count < ARENA_REGISTRY_MAX);
+
+  registry->arenas[registry->count] = arena;
+  registry->names[registry->count] = name;
+  registry->count++;
+}
+
+void arena_unregister(Arena *arena) {
+  Arena_registry *registry = &arena_registry;
+
+  for(s32 i = 0; i < registry->count; i++) {
+    if(registry->arenas[i] == arena) {
+      /* keep the order they were registered in for the views */
+      for(s32 j = i + 1; j < registry->count; j++) {
+        registry->arenas[j - 1] = registry->arenas[j];
+        registry->names[j - 1] = registry->names[j];
+      }
+      registry->count--;
+      break;
+    }
+  }
+}
+
 
 
 #endif
@@ -67,6 +67,12 @@ struct __Slice_header {
 #define arr_push_n_ptr(array, n) ((arr_push_no_zero_(header_ptr_from_arr((array)), arr_stride(array), (n))), &((array).d[(array).count - (n)]))
 #define arr_push_n_index(array, n) ((arr_push_no_zero_(header_ptr_from_arr((array)), arr_stride(array), (n))), (s64)((array).count - (n)))
 
+#define arr_ins(array, index, elem) ((arr_insn_(header_ptr_from_arr((array)), arr_stride(array), (index), 1)), (array).d[(index)] = (elem))
+#define arr_insn(array, index, n) arr_insn_(header_ptr_from_arr((array)), arr_stride(array), (index), (n))
+#define arr_del(array, index) arr_deln_(header_ptr_from_arr((array)), arr_stride(array), (index), 1)
+#define arr_deln(array, index, n) arr_deln_(header_ptr_from_arr((array)), arr_stride(array), (index), (n))
+#define arr_delswap(array, index) arr_delswap_(header_ptr_from_arr((array)), arr_stride(array), (index))
+
 #define arr_pop(array)        ( ( ((array).count > 0) ? ((array).count--) : (0) ), (array).d[(array).count] )
 #define arr_first(array) ((array).d[0])
 #define arr_last(array) ((array).d[(array).count-1])
@@ -79,6 +85,9 @@ struct __Slice_header {
 
 void  arr_init_(__Arr_header *arr, Arena *arena, s64 stride, s64 cap);
 void* arr_push_no_zero_(__Arr_header *arr, s64 stride, s64 push_count);
+void* arr_insn_(__Arr_header *arr, s64 stride, s64 index, s64 n);
+void  arr_deln_(__Arr_header *arr, s64 stride, s64 index, s64 n);
+void  arr_delswap_(__Arr_header *arr, s64 stride, s64 index);
 
 // TODO
 //
@@ -102,33 +111,67 @@ void* arr_push_no_zero_(__Arr_header *arr, s64 stride, s64 push_count);
 
 void arr_init_(__Arr_header *arr, Arena *arena, s64 stride, s64 cap) {
   arr->count = 0;
-  arr->cap = cap;
+  arr->cap = CLAMP_BOT(cap, 1);
   arr->arena = arena;
-  arr->d = arena_push(arena, cap * stride, 1);
+  arr->d = arena_push(arena, arr->cap * stride, 8);
 }
 
 void* arr_push_no_zero_(__Arr_header *arr, s64 stride, s64 push_count) {
   ASSERT(arr->d && arr->cap && arr->arena);
 
-  if(arr->count + push_count >= arr->cap) {
+  if(arr->count + push_count > arr->cap) {
     s64 new_cap = arr->cap << 1;
 
     while(new_cap < arr->count + push_count) {
       new_cap <<= 1;
     }
 
-    void *new_d = arena_push(arr->arena, new_cap * stride, 1);
-    memory_copy(new_d, arr->d, stride * (arr->count + push_count));
-    arr->d = new_d;
+    /* when the buffer is the arena's last push it just gets longer, otherwise the old one is left behind */
+    if(!arena_grow_in_place(arr->arena, arr->d, arr->cap * stride, new_cap * stride)) {
+      void *new_d = arena_push(arr->arena, new_cap * stride, 8);
+      memory_copy(new_d, arr->d, stride * arr->count);
+      arr->d = new_d;
+    }
+
     arr->cap = new_cap;
   }
 
-  void *result = (u8*)(arr->d) + arr->count;
+  void *result = (u8*)(arr->d) + arr->count * stride;
   arr->count += push_count;
 
   return result;
 }
 
+void* arr_insn_(__Arr_header *arr, s64 stride, s64 index, s64 n) {
+  ASSERT(index >= 0 && index <= arr->count && n >= 0);
+
+  s64 tail_count = arr->count - index;
+  arr_push_no_zero_(arr, stride, n);
+
+  u8 *at = (u8*)(arr->d) + index * stride;
+  memory_copy(at + n * stride, at, tail_count * stride);
+
+  return at;
+}
+
+void arr_deln_(__Arr_header *arr, s64 stride, s64 index, s64 n) {
+  ASSERT(index >= 0 && n >= 0 && index + n <= arr->count);
+
+  u8 *at = (u8*)(arr->d) + index * stride;
+  memory_copy(at, at + n * stride, (arr->count - index - n) * stride);
+  arr->count -= n;
+}
+
+void arr_delswap_(__Arr_header *arr, s64 stride, s64 index) {
+  ASSERT(index >= 0 && index < arr->count);
+
+  arr->count--;
+
+  if(index != arr->count) {
+    memory_copy((u8*)(arr->d) + index * stride, (u8*)(arr->d) + arr->count * stride, stride);
+  }
+}
+
 /*
 
 arrpop:
@@ -7,13 +7,30 @@
 #include "str.h"
 
 
+/*
+ * Every thread has CONTEXT_SCRATCH_COUNT scratch arenas, made by context_init,
+ * which each thread has to call at startup before touching scratch memory, and
+ * freed by context_close. The scratch_* macros below use the first one.
+ *
+ * A function that gets an arena to push its results on and also wants scratch
+ * memory passes that arena as a conflict, so the two never share an arena:
+ *
+ *   Arena_scope scratch = scratch_begin(&arena, 1);
+ *   ...
+ *   scratch_end(scratch);
+ */
+#define CONTEXT_SCRATCH_COUNT 2
+
 void context_init(void);
 void context_close(void);
 
 void scratch_clear(void);
 
+Arena_scope scratch_begin(Arena **conflicts, s64 conflicts_count);
+#define scratch_end(scope) scope_end((scope))
+
 #define scratch_pos() arena_pos(context_scratch_arena)
-#define scratch_pop_to(amount) arena_pop_to(context_scratch_arena, (pos))
+#define scratch_pop_to(pos) arena_pop_to(context_scratch_arena, (pos))
 #define scratch_pop(amount) arena_pop(context_scratch_arena, (amount))
 
 #define scratch_push(size, align) arena_push(context_scratch_arena, (size), (align))
@@ -48,19 +65,55 @@ char* scratch_push_cstrf(char *fmt, ...);
 #define JLIB_CONTEXT_IMPL
 #endif
 
-thread_static Arena *context_scratch_arena;
+thread_static Arena *context_scratch_arenas[CONTEXT_SCRATCH_COUNT];
+thread_static Arena *context_scratch_arena; // context_scratch_arenas[0]
 
 force_inline void scratch_clear(void) {
   arena_clear(context_scratch_arena);
 }
 
 void context_init(void) {
-  Arena_params arena_params = { .size = ARENA_DEFAULT_SIZE, .cannot_chain = 0, };
-  context_scratch_arena = arena_alloc_(&arena_params);
+  Arena_params arena_params = { .size = ARENA_DEFAULT_SIZE, .reserve_size = GB(1), .cannot_chain = 0, };
+
+  for(s32 i = 0; i < CONTEXT_SCRATCH_COUNT; i++) {
+    context_scratch_arenas[i] = arena_alloc_(&arena_params);
+  }
+
+  context_scratch_arena = context_scratch_arenas[0];
 }
 
 void context_close(void) {
-  arena_free(context_scratch_arena);
+  for(s32 i = 0; i < CONTEXT_SCRATCH_COUNT; i++) {
+    arena_free(context_scratch_arenas[i]);
+    context_scratch_arenas[i] = 0;
+  }
+
+  context_scratch_arena = 0;
+}
+
+Arena_scope scratch_begin(Arena **conflicts, s64 conflicts_count) {
+  Arena *result = 0;
+
+  for(s32 i = 0; i < CONTEXT_SCRATCH_COUNT && !result; i++) {
+    Arena *candidate = context_scratch_arenas[i];
+    b32 conflicting = 0;
+
+    for(s64 j = 0; j < conflicts_count; j++) {
+      if(conflicts[j] == candidate) {
+        conflicting = 1;
+        break;
+      }
+    }
+
+    if(!conflicting) {
+      result = candidate;
+    }
+  }
+
+  /* more conflicts than scratch arenas, or context_init wasn't called on this thread */
+  ASSERT(result);
+
+  return scope_begin(result);
 }
 
 char* scratch_push_cstrf(char *fmt, ...) {
@@ -0,0 +1,288 @@
+#define RAYMATH_IMPLEMENTATION
+#define HEADLESS
+
+#include "jurassic.c"
+#include "raylib_null.c"
+
+#ifndef DEBUG
+#error "the headless build runs the debug sandbox, build it with -DDEBUG"
+#endif
+
+#ifdef PROF_DISABLE
+#error "the headless timings are read from the profiler, build it without -DPROF_DISABLE"
+#endif
+
+/*
+ * Runs the simulation with no window, GL or audio as fast as the CPU allows,
+ * one sim tick per frame, and reports how long each part of a tick took.
+ *
+ * usage: jurassic_headless [-scenario NAME|all] [-count N] [-ticks N] [-replay FILE] [-trace FILE]
+ *
+ * -scenario runs one of the SCENARIOS in jurassic.c, or every one of them in turn.
+ * -count overrides the scenario's default count.
+ * -replay plays back a recording instead, and with 0 ticks runs until it ends.
+ * With neither it runs the empty sandbox.
+ * -trace writes the profiler's last PROF_FRAMES ticks as Chrome trace JSON at the end.
+ * Last it prints the stats of every registered arena.
+ */
+
+#define HEADLESS_DEFAULT_TICKS (60 * 60)
+
+/* the profiler zones of a tick that get a column each, after them comes one per entity system */
+#define SIM_TIMERS                   \
+  X(TICK,         "tick")            \
+  X(SCENARIO,     "scenario")        \
+  X(SPATIAL_GRID, "spatial grid")    \
+  X(PROJECTILES,  "projectiles")     \
+  X(CONTROL,      "control")         \
+  X(SYSTEMS,      "systems")         \
+  X(PARTICLES,    "particles")       \
+
+typedef enum Sim_timer {
+#define X(timer, zone) SIM_TIMER_##timer,
+  SIM_TIMERS
+#undef X
+    SIM_TIMER_MAX,
+} Sim_timer;
+
+char *Sim_timer_strings[SIM_TIMER_MAX] = {
+#define X(timer, zone) #timer,
+  SIM_TIMERS
+#undef X
+};
+
+char *Sim_timer_zones[SIM_TIMER_MAX] = {
+#define X(timer, zone) zone,
+  SIM_TIMERS
+#undef X
+};
+
+/* every tick's timings, one row of SIM_TIMER_MAX + ENTITY_SYSTEM_MAX per tick */
+typedef struct Timing_samples Timing_samples;
+struct Timing_samples {
+  f64 *d;
+  s64  count;
+  s64  cap;
+};
+
+#define TIMING_COLUMNS (SIM_TIMER_MAX + ENTITY_SYSTEM_MAX)
+
+int compare_f64(const void *a, const void *b) {
+  f64 x = *(const f64*)a;
+  f64 y = *(const f64*)b;
+  return (x > y) - (x < y);
+}
+
+/* nearest rank on an already sorted array */
+f64 percentile(f64 *sorted, s64 count, f64 p) {
+  s64 rank = (s64)ceil(p * (f64)count);
+  return sorted[CLAMP_TOP(CLAMP_BOT(rank - 1, 0), count - 1)];
+}
+
+/* seconds in each zone of the frame that just ended, summed over both entity orders */
+void timing_row_from_last_frame(f64 *row) {
+  memory_zero(row, sizeof(f64) * TIMING_COLUMNS);
+
+  Prof_frame *frame = prof_last_frame();
+
+  for(s32 i = 0; i < frame->zones_count; i++) {
+    Prof_zone *zone = frame->zones + i;
+    f64 seconds = 1e-9 * (f64)(zone->end_ns - zone->begin_ns);
+
+    for(Sim_timer timer = 0; timer < SIM_TIMER_MAX; timer++) {
+      if(!strcmp(zone->name, Sim_timer_zones[timer])) row[timer] += seconds;
+    }
+
+    for(Entity_system system = 0; system < ENTITY_SYSTEM_MAX; system++) {
+      if(!strcmp(zone->name, Entity_system_strings[system])) row[SIM_TIMER_MAX + system] += seconds;
+    }
+  }
+}
+
+void print_timing_row(Arena *arena, Timing_samples *samples, s64 column, char *name) {
+  Arena_scope scope = scope_begin(arena);
+
+  f64 *sorted = push_array_no_zero(arena, f64, samples->count);
+  f64 sum = 0;
+
+  for(s64 i = 0; i < samples->count; i++) {
+    sorted[i] = samples->d[i * TIMING_COLUMNS + column];
+    sum += sorted[i];
+  }
+
+  qsort(sorted, samples->count, sizeof(f64), compare_f64);
+
+  /* systems no entity had the flag for never ran */
+  if(sorted[samples->count - 1] > 0) {
+    printf("  %-34s %9.4f %9.4f %9.4f %9.4f %9.4f\n",
+        name,
+        1000.0 * sum / (f64)samples->count,
+        1000.0 * percentile(sorted, samples->count, 0.50),
+        1000.0 * percentile(sorted, samples->count, 0.90),
+        1000.0 * percentile(sorted, samples->count, 0.99),
+        1000.0 * sorted[samples->count - 1]);
+  }
+
+  scope_end(scope);
+}
+
+b32 run(Game *gp, Arena *arena, Timing_samples *samples, Scenario scenario, s32 count, s64 ticks, char *replay_path) {
+  char *name = "SANDBOX";
+
+  if(replay_path) {
+    game_reset(gp);
+
+    if(!replay_playback_begin(gp, replay_path)) {
+      TraceLog(LOG_ERROR, "HEADLESS: could not play %s", replay_path);
+      return 0;
+    }
+
+    if(ticks <= 0) ticks = gp->replay.header.ticks_count;
+    name = replay_path;
+  } else if(scenario != SCENARIO_NONE) {
+    scenario_begin(gp, scenario, count);
+    name = Scenario_strings[scenario];
+  } else {
+    game_reset(gp);
+  }
+
+  if(ticks <= 0) ticks = HEADLESS_DEFAULT_TICKS;
+
+  if(samples->cap < ticks) {
+    samples->d = push_array_no_zero(arena, f64, ticks * TIMING_COLUMNS);
+    samples->cap = ticks;
+  }
+  samples->count = 0;
+
+  f64 begin = GetTime();
+
+  for(s64 i = 0; i < ticks && !gp->quit; i++) {
+    u64 tick_index = gp->tick_index;
+
+    game_update_and_draw(gp);
+
+    if(gp->tick_index == tick_index) continue;
+
+    timing_row_from_last_frame(samples->d + samples->count++ * TIMING_COLUMNS);
+  }
+
+  f64 elapsed = GetTime() - begin;
+
+  printf("%s", name);
+  if(scenario != SCENARIO_NONE) printf(" count %i", gp->scenario.count);
+  printf(": %lli ticks in %.3f s, %.1f ticks per second\n",
+      (long long)samples->count, elapsed, (f64)samples->count / elapsed);
+  printf("  live entities %i, particles %i, projectiles %lli\n",
+      gp->live_entities, gp->live_particles, (long long)gp->projectiles_count);
+
+  if(samples->count > 0) {
+    printf("  %-34s %9s %9s %9s %9s %9s\n", "ms", "mean", "p50", "p90", "p99", "max");
+
+    for(Sim_timer timer = 0; timer < SIM_TIMER_MAX; timer++) {
+      print_timing_row(arena, samples, timer, Sim_timer_strings[timer]);
+    }
+
+    for(Entity_system system = 0; system < ENTITY_SYSTEM_MAX; system++) {
+      char label[64];
+      stbsp_snprintf(label, sizeof(label), "SYSTEM_%s", Entity_system_strings[system]);
+      print_timing_row(arena, samples, SIM_TIMER_MAX + system, label);
+    }
+  }
+
+  printf("\n");
+
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  s64 ticks = 0;
+  s32 count = 0;
+  char *scenario_name = 0;
+  char *replay_path = 0;
+  char *trace_path = 0;
+
+  for(int i = 1; i < argc; i++) {
+    char *arg = argv[i];
+
+    if(i + 1 >= argc) {
+      TraceLog(LOG_ERROR, "HEADLESS: %s is missing its value", arg);
+      return 1;
+    }
+
+    if(!strcmp(arg, "-ticks")) {
+      ticks = atoll(argv[++i]);
+    } else if(!strcmp(arg, "-count")) {
+      count = atoi(argv[++i]);
+    } else if(!strcmp(arg, "-scenario")) {
+      scenario_name = argv[++i];
+    } else if(!strcmp(arg, "-replay")) {
+      replay_path = argv[++i];
+    } else if(!strcmp(arg, "-trace")) {
+      trace_path = argv[++i];
+    } else {
+      TraceLog(LOG_ERROR, "HEADLESS: unknown argument %s", arg);
+      return 1;
+    }
+  }
+
+  Scenario first = SCENARIO_NONE;
+  Scenario last = SCENARIO_NONE;
+
+  /* a replay brings its own input, it doesn't mix with a scenario */
+  if(scenario_name && !replay_path) {
+    if(!strcmp(scenario_name, "all")) {
+      first = SCENARIO_NONE + 1;
+      last = SCENARIO_MAX - 1;
+    } else {
+      for(Scenario scenario = SCENARIO_NONE + 1; scenario < SCENARIO_MAX; scenario++) {
+        if(!strcmp(scenario_name, Scenario_strings[scenario])) {
+          first = last = scenario;
+        }
+      }
+
+      if(first == SCENARIO_NONE) {
+        TraceLog(LOG_ERROR, "HEADLESS: no scenario named %s, pick one of", scenario_name);
+        for(Scenario scenario = SCENARIO_NONE + 1; scenario < SCENARIO_MAX; scenario++) {
+          TraceLog(LOG_ERROR, "  %s", Scenario_strings[scenario]);
+        }
+        return 1;
+      }
+    }
+  }
+
+  Game *gp = game_init();
+  Arena *arena = arena_alloc(.size = MB(4));
+  Timing_samples samples = {0};
+
+  for(Scenario scenario = first; scenario <= last; scenario++) {
+    if(!run(gp, arena, &samples, scenario, count, ticks, replay_path)) {
+      return 1;
+    }
+  }
+
+  printf("%-10s %12s %12s %8s %8s %8s %12s\n", "arena", "pos", "peak", "chained", "reused", "commits", "align waste");
+
+  for(s32 i = 0; i < arena_registry.count; i++) {
+    Arena *arena = arena_registry.arenas[i];
+    Arena_stats *stats = &arena->stats;
+    printf("%-10s %12llu %12llu %8u %8u %8u %12llu\n",
+        arena_registry.names[i],
+        (unsigned long long)arena_pos(arena),
+        (unsigned long long)stats->peak_pos,
+        stats->chain_count,
+        stats->free_list_hits,
+        stats->commit_count,
+        (unsigned long long)stats->align_waste);
+  }
+
+  printf("\n");
+
+  if(trace_path && !trace_write(gp, trace_path)) {
+    TraceLog(LOG_ERROR, "HEADLESS: could not write %s", trace_path);
+    return 1;
+  }
+
+  game_close(gp);
+
+  return 0;
+}
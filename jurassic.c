@@ -7,8 +7,15 @@
 #include "str.h"
 #include "context.h"
 #include "array.h"
+#include "pool.h"
 #include "sprite.h"
 #include "stb_sprintf.h"
+#include "simd.h"
+#include "rng.h"
+#include "prof.h"
+
+#include "third_party/microui/microui.h"
+#include "third_party/microui/murl.h"
 
 
 /*
@@ -18,6 +25,8 @@
 #define GAME_TITLE "Jurassic"
 #define TARGET_FPS 60
 #define TARGET_FRAME_TIME ((float)(1.0f / (float)TARGET_FPS))
+#define SIM_DT TARGET_FRAME_TIME
+#define MAX_SIM_TICKS_PER_FRAME 6 /* a tenth of a second, past that the game slows down instead of spiralling */
 
 #define WINDOW_WIDTH  ((float)GetScreenWidth())
 #define WINDOW_HEIGHT ((float)GetScreenHeight())
@@ -25,17 +34,47 @@
 #define WINDOW_SIZE ((Vector2){ WINDOW_WIDTH, WINDOW_HEIGHT })
 #define WINDOW_RECT ((Rectangle){0, 0, WINDOW_WIDTH, WINDOW_HEIGHT})
 
+#define RNG_SEED 42
+
+#define REPLAY_PATH "./replay.jrep"
+#define REPLAY_MAGIC 0x5045524a /* "JREP" */
+#define REPLAY_VERSION 2 /* 1 culled against the interpolated camera, those recordings don't play back */
+#define REPLAY_CHUNK_TICKS 4096
+
+#define TRACE_PATH "./trace.json"
+
+#define SCENARIO_ROOM_FIRST_TILE 1 /* row and col of the top left wall of the scenario room */
+#define SCENARIO_ROOM_TILES 80
+#define SCENARIO_DOOR_SPACING 8 /* tiles between doors, enough that opening one never opens its neighbours */
+#define SCENARIO_DOOR_TILES 3
+#define SCENARIO_MAX_DOORS_PER_SIDE ((SCENARIO_ROOM_TILES - 4) / SCENARIO_DOOR_SPACING)
+#define SCENARIO_CROSSFIRE_TARGETS 256
+#define SCENARIO_DOORS_RAPTORS 1024
+#define SCENARIO_BULLET_VEL 900.0f
+
 #define MAX_ENTITIES 4096
 #define MAX_PARTICLES 8192
+#define PARTICLE_SPAWN_CHUNK 64 /* particles emit_particles draws random numbers for at once */
+#define MAX_PROJECTILES 8192
 #define MAX_BULLETS_IN_BAG 8
 #define MAX_PARENTS 32
 #define MAX_ENTITY_LISTS 16
+#define ENTITY_UID_TABLE_SIZE (MAX_ENTITIES*2) /* must be a power of 2 */
+
+#define SPATIAL_GRID_CELL_SIZE 64
+#define INV_SPATIAL_GRID_CELL_SIZE ((float)(1.0f/(float)SPATIAL_GRID_CELL_SIZE))
+#define SPATIAL_GRID_BUCKETS 4096 /* must be a power of 2 */
+#define SPATIAL_GRID_MAX_CELLS_PER_ENTITY 64
 
 #define TILE_SIZE 32
 #define INV_TILE_SIZE ((float)(1.0f/(float)TILE_SIZE))
 #define TILE_ROWS 256
 #define TILE_COLS 256
 #define TILES_COUNT (TILE_ROWS*TILE_COLS)
+#define TILE_CHUNK_SIZE 32 /* tiles per chunk side */
+#define TILE_CHUNK_COLS (TILE_COLS/TILE_CHUNK_SIZE)
+#define TILE_CHUNK_ROWS (TILE_ROWS/TILE_CHUNK_SIZE)
+#define TILE_CHUNKS_COUNT (TILE_CHUNK_ROWS*TILE_CHUNK_COLS)
 #define MAX_STATIC_ENTITIES 256
 #define MAP_WIDTH ((float)TILE_SIZE*TILE_COLS+TILE_SIZE)
 #define MAP_HEIGHT ((float)TILE_SIZE*TILE_ROWS+TILE_SIZE)
@@ -63,6 +102,30 @@
   X(VICTORY)                    \
   X(DEBUG_SANDBOX)              \
 
+#define REPLAY_MODES            \
+  X(NONE)                       \
+  X(RECORD)                     \
+  X(PLAYBACK)                   \
+
+/*
+ * Scripted stress loads for the sandbox, the headless build runs them to time
+ * the simulation at scale. The count is how many raptors, projectiles, bursts
+ * per tick or doors the scenario keeps going.
+ */
+#define SCENARIOS                \
+  X(NONE,             0)         \
+  X(RAPTOR_CHASE,     2048)      \
+  X(BULLET_CROSSFIRE, 4096)      \
+  X(PARTICLE_BURSTS,  4)         \
+  X(DOORS_UNDER_LOAD, 64)        \
+
+/* pair tests the sim ran in the last frame, shown in the debug window */
+#define COLLISION_COUNTERS       \
+  X(GRID_QUERIES)                \
+  X(CANDIDATES)                  \
+  X(ENTITY_TESTS)                \
+  X(TILE_SEGMENT_TESTS)          \
+
 #define GAME_DEBUG_FLAGS       \
   X(DEBUG_UI)                  \
   X(PLAYER_INVINCIBLE)         \
@@ -116,6 +179,7 @@
   X(BOUNCE_OFF_TILES)                \
   X(HAS_SPRITE)                      \
   X(MANUAL_SPRITE_ORIGIN)            \
+  X(FOLLOW_HOLDER)                   \
   X(APPLY_FRICTION)                  \
   X(FILL_BOUNDS)                     \
   X(HAS_GUN)                         \
@@ -149,6 +213,26 @@
   X(GOTO_WAYPOINT)                    \
   X(DOOR)                             \
 
+#define ENTITY_SYSTEMS                               \
+  X(FRICTION,                  APPLY_FRICTION)       \
+  X(DYNAMICS,                  DYNAMICS)             \
+  X(SPINNING,                  SPINNING)             \
+  X(CONTINUOUS_TILE_COLLISION, CONTINUOUS_TILE_COLLISION) \
+  X(DISCRETE_TILE_COLLISION,   DISCRETE_TILE_COLLISION) \
+  X(FOLLOW_HOLDER,             FOLLOW_HOLDER)        \
+  X(SHOOT_GUN,                 HAS_GUN)              \
+  X(INTERACT,                  INTERACT)             \
+  X(APPLY_COLLISION,           APPLY_COLLISION)      \
+  X(DIE_IF_CHILD_LIST_EMPTY,   DIE_IF_CHILD_LIST_EMPTY) \
+  X(DIE_ON_APPLY_COLLISION,    DIE_ON_APPLY_COLLISION) \
+  X(EFFECT_TINT,               APPLY_EFFECT_TINT)    \
+  X(RECEIVE_COLLISION,         RECEIVE_COLLISION)    \
+  X(SPRITE,                    HAS_SPRITE)           \
+  X(ENTER_SCREEN,              NOT_ON_SCREEN)        \
+  X(LIFETIME,                  HAS_LIFETIME)         \
+  X(SPAWN_PARTICLES,           EMIT_SPAWN_PARTICLES) \
+  X(DIE,                       DIE_NOW)              \
+
 #define PARTICLE_EMITTERS        \
   X(SPARKS)                      \
   X(PURPLE_SPARKS)               \
@@ -164,6 +248,31 @@
 
 #define PARTICLE_FLAGS            \
 
+#define PARTICLE_POOL_FIELDS     \
+  X(f32,   pos_x)                \
+  X(f32,   pos_y)                \
+  X(f32,   vel_x)                \
+  X(f32,   vel_y)                \
+  X(f32,   radius)               \
+  X(f32,   shrink)               \
+  X(f32,   friction)             \
+  X(f32,   live)                 \
+  X(f32,   lifetime)             \
+  X(Color, begin_tint)           \
+  X(Color, end_tint)             \
+
+/*
+ * Each system draws from its own stream so that, say, a change to how many
+ * particles an explosion spawns can't shift the gameplay rolls after it.
+ * GAMEPLAY and AI are reseeded on every game_reset, PARTICLES and COSMETIC
+ * only once in game_init and keep running across restarts.
+ */
+#define RNG_STREAMS                 \
+  X(PARTICLES)                      \
+  X(GAMEPLAY)                       \
+  X(AI)                             \
+  X(COSMETIC)                       \
+
 #define GUN_KINDS                   \
   X(SHOTGUN)                        \
   X(ASSAULT_RIFLE)                  \
@@ -231,10 +340,15 @@ typedef struct Game Game;
 typedef struct Map_data Map_data;
 typedef struct Collision_manifold Collision_manifold;
 typedef struct Editor Editor;
+typedef struct Spatial_grid Spatial_grid;
 typedef u64 Editor_flags;
 typedef struct Entity Entity;
 typedef Entity* Entity_ptr;
-typedef struct Particle Particle;
+typedef struct Entity_cold Entity_cold;
+typedef struct Particle_burst Particle_burst;
+typedef struct Particle_emitter_def Particle_emitter_def;
+typedef struct Particle_pool Particle_pool;
+typedef struct Projectile Projectile;
 typedef struct Gun Gun;
 typedef u64 Game_flags;
 typedef u64 Game_debug_flags;
@@ -252,6 +366,9 @@ typedef struct Entity_node Entity_node;
 typedef struct Entity_list Entity_list;
 typedef struct Waypoint Waypoint;
 typedef struct Waypoint_list Waypoint_list;
+typedef struct Replay_header Replay_header;
+typedef struct Replay_tick Replay_tick;
+typedef struct Replay_chunk Replay_chunk;
 typedef void (*Waypoint_action_proc)(Game *gp, Entity *this_entity);
 typedef void (*Entity_collide_proc)(Game *gp, Entity *this_entity, Entity *other_entity);
 typedef void (*Entity_interact_proc)(Game *gp, Entity *this_entity, Entity *other_entity);
@@ -270,6 +387,51 @@ char *Game_state_strings[GAME_STATE_MAX] = {
 #undef X
 };
 
+typedef enum Replay_mode {
+#define X(mode) REPLAY_MODE_##mode,
+  REPLAY_MODES
+#undef X
+    REPLAY_MODE_MAX,
+} Replay_mode;
+
+char *Replay_mode_strings[REPLAY_MODE_MAX] = {
+#define X(mode) #mode,
+  REPLAY_MODES
+#undef X
+};
+
+typedef enum Scenario {
+#define X(name, count) SCENARIO_##name,
+  SCENARIOS
+#undef X
+    SCENARIO_MAX,
+} Scenario;
+
+char *Scenario_strings[SCENARIO_MAX] = {
+#define X(name, count) #name,
+  SCENARIOS
+#undef X
+};
+
+const s32 Scenario_default_counts[SCENARIO_MAX] = {
+#define X(name, count) count,
+  SCENARIOS
+#undef X
+};
+
+typedef enum Collision_counter {
+#define X(counter) COLLISION_COUNTER_##counter,
+  COLLISION_COUNTERS
+#undef X
+    COLLISION_COUNTER_MAX,
+} Collision_counter;
+
+char *Collision_counter_strings[COLLISION_COUNTER_MAX] = {
+#define X(counter) #counter,
+  COLLISION_COUNTERS
+#undef X
+};
+
 typedef enum Game_flag_index {
   GAME_FLAG_INDEX_INVALID = -1,
 #define X(flag) GAME_FLAG_INDEX_##flag,
@@ -307,11 +469,14 @@ typedef enum Input_flag_index {
 } Input_flag_index;
 
 STATIC_ASSERT(INPUT_FLAG_INDEX_MAX < 64, number_of_input_flags_is_less_than_64);
+STATIC_ASSERT(INPUT_FLAG_INDEX_MAX <= 16, input_flags_fit_in_a_replay_tick);
 
 #define X(flag) const Input_flags INPUT_FLAG_##flag = (Input_flags)(1ull<<INPUT_FLAG_INDEX_##flag);
 INPUT_FLAGS
 #undef X
 const Input_flags INPUT_FLAG_MOVE = INPUT_FLAG_MOVE_FORWARD | INPUT_FLAG_MOVE_LEFT | INPUT_FLAG_MOVE_RIGHT | INPUT_FLAG_MOVE_BACKWARD;
+/* resampled every frame, every other input flag is a press that stays set until a sim tick consumes it */
+const Input_flags INPUT_FLAG_HELD = INPUT_FLAG_MOVE | INPUT_FLAG_SHOOT_HOLD;
 
 typedef enum Entity_kind {
   ENTITY_KIND_INVALID = 0,
@@ -364,6 +529,27 @@ ENTITY_FLAGS
 
 STATIC_ASSERT(ENTITY_FLAG_INDEX_MAX < 64, number_of_entity_flags_is_less_than_64);
 
+typedef enum Entity_system {
+  ENTITY_SYSTEM_INVALID = -1,
+#define X(system, flag) ENTITY_SYSTEM_##system,
+  ENTITY_SYSTEMS
+#undef X
+    ENTITY_SYSTEM_MAX,
+} Entity_system;
+
+char *Entity_system_strings[ENTITY_SYSTEM_MAX] = {
+#define X(system, flag) #system,
+  ENTITY_SYSTEMS
+#undef X
+};
+
+/* an entity takes part in a system when it has the system's flag */
+const Entity_flags Entity_system_flags[ENTITY_SYSTEM_MAX] = {
+#define X(system, flag) ENTITY_FLAG_##flag,
+  ENTITY_SYSTEMS
+#undef X
+};
+
 typedef enum Particle_flag_index {
   PARTICLE_FLAG_INDEX_INVALID = -1,
 #define X(flag) PARTICLE_FLAG_INDEX_##flag,
@@ -386,6 +572,13 @@ typedef enum Particle_emitter {
     PARTICLE_EMITTER_MAX,
 } Particle_emitter;
 
+typedef enum Rng_stream {
+#define X(stream) RNG_STREAM_##stream,
+  RNG_STREAMS
+#undef X
+    RNG_STREAM_MAX,
+} Rng_stream;
+
 typedef enum Gun_kind {
   GUN_KIND_INVALID = 0,
 #define X(kind) GUN_KIND_##kind,
@@ -532,19 +725,73 @@ struct Collision_manifold {
   f32 u;
 };
 
-struct Particle {
-  Particle_flags flags;
+/*
+ * One layer of a particle effect. Emitters are lists of these, generated from
+ * particle_emitters.json by the metaprogram into particle_data.c, and every
+ * range is sampled uniformly per particle by emit_particles.
+ */
+struct Particle_burst {
+  s32   count_min, count_max;
+  f32   lifetime_min, lifetime_max;
+  f32   speed_min, speed_max;
+  f32   radius_min, radius_max; /* this says radius, but the particles are squares */
+  f32   friction_min, friction_max;
+  f32   spread;          /* half angle around the aim direction */
+  b32   aim_against_vel; /* aim opposite the emitter's velocity instead of straight up */
+  f32   shrink;          /* fraction of the starting radius lost over the lifetime */
+  f32   shrink_rate;     /* plus a constant shrink per second */
+  Color begin_tint;
+  Color end_tint;
+};
+
+struct Particle_emitter_def {
+  s32 first_burst;
+  s32 bursts_count;
+};
 
-  f32 live;
-  f32 lifetime;
+/*
+ * Live particles packed at the front of structure of arrays storage so
+ * particles_update can run over them SIMD_WIDTH at a time. Dead particles are
+ * squeezed out in order every update, so the oldest ones are always first.
+ */
+struct Particle_pool {
+#define X(type, field) type *field;
+  PARTICLE_POOL_FIELDS
+#undef X
+  s64 count;
+};
 
+/*
+ * Bullets that only move, hit tiles, damage entities and die don't need a
+ * whole Entity. They live in a flat pool updated in batches by
+ * projectiles_update. Guns whose bullets need anything more still spawn
+ * entities, see PROJECTILE_BULLET_FLAGS.
+ */
+struct Projectile {
   Vector2 pos;
+  Vector2 prev_pos;
   Vector2 vel;
-  f32     radius; /* this says radius, but the particles are squares */
-  f32     shrink;
+  f32     radius;
   f32     friction;
-  Color   begin_tint;
-  Color   end_tint;
+
+  f32 life_timer;
+  f32 lifetime; /* 0 means it lives until it hits something */
+
+  b32 dead;
+
+  s32 damage;
+  Entity_kind_mask collision_mask;
+
+  Entity_flags flags;
+
+  Particle_emitter death_particle_emitter;
+
+  Sprite_frame sprite_frame;
+  f32          sprite_scale;
+  f32          sprite_rotation;
+  Color        sprite_tint;
+
+  Color bounds_color;
 };
 
 struct Gun {
@@ -623,34 +870,73 @@ struct Entity_list {
   s64 count;
 };
 
+/*
+ * A handle is an entity slot plus the generation of that slot when the handle
+ * was made. entity_die bumps the slot's generation, which invalidates every
+ * outstanding handle to it. Generation 0 is never live, so a zeroed handle is
+ * always invalid.
+ */
 struct Entity_handle {
-  u64     uid;
-  Entity *ep;
+  u16 slot;
+  u16 generation;
 };
 
+STATIC_ASSERT(sizeof(Entity_handle) == 4, entity_handle_is_32_bits);
+
 struct Entity_node {
   Entity_node *next;
   Entity_node *prev;
-  union {
-    Entity_handle handle;
-    struct {
-      u64     uid;
-      Entity *ep;
-    };
-  };
+  Entity_handle handle;
 };
 
+/*
+ * Entity is laid out hot first. The fields every system touches every update
+ * come first so iterating the entity pool streams the first cache line or two
+ * of each entity. Data only a few kinds of entity use (guns, doors, waypoints,
+ * sounds) lives in the Entity_cold side table, keyed by entity slot index.
+ */
 struct Entity {
+
+  /* hot */
   b32 live;
 
   Entity_kind    kind;
   Entity_order   update_order;
-  Entity_order   draw_order;
-
   Entity_control control;
 
   Entity_flags   flags;
 
+  Vector2 pos;
+  Vector2 vel;
+  Vector2 accel;
+  f32     radius;
+  f32     friction;
+
+  /* written at the start of each update, read by the systems after it and by the draw interpolation */
+  Vector2 prev_pos;
+  f32     prev_look_angle;
+  b8      on_screen;
+  b8      fully_on_screen;
+  b8      applied_collision;
+  b8      has_prev_state; /* clear until the first update, spawned entities draw where they are */
+
+  Entity_order   draw_order;
+
+  f32     scalar_vel;
+  f32     look_angle;
+  f32     spin_vel;
+  Vector2 look_dir;
+
+  Entity_kind_mask apply_collision_mask;
+
+  b32 received_collision;
+  s32 received_damage;
+
+  s32 damage_amount;
+
+  s32 health;
+
+  /* warm */
   Entity *free_list_next;
 
   u64 uid;
@@ -667,48 +953,26 @@ struct Entity {
   Entity_list *parent_list;
   Entity_node *list_node;
 
-  Vector2 look_dir;
-  Vector2 accel;
-  Vector2 vel;
-  Vector2 pos;
-  f32     radius;
+  s32 update_list_index;
+  s32 draw_list_index;
+
   f32     interact_radius;
-  f32     scalar_vel;
-  f32     friction;
-  f32     look_angle;
-  f32     spin_vel;
 
   f32 shooting_pause_timer;
   f32 start_shooting_delay;
 
-  b32 received_collision;
-  s32 received_damage;
-
-  s32 damage_amount;
-
-  s32 health;
-
   Color bounds_color;
   Color fill_color;
 
-  Waypoint_list waypoints;
-  Waypoint     *cur_waypoint;
-
   Particle_emitter particle_emitter;
   Particle_emitter spawn_particle_emitter;
   Particle_emitter death_particle_emitter;
 
-  Gun gun;
-
   Vector2 being_held_offset;
 
   Key_color key_color;
   Door_color door_color;
 
-  s64 door_tiles[8];
-  s64 door_tiles_count;
-
-  Entity_kind_mask apply_collision_mask;
   Entity_collide_proc collide_proc;
   Entity_interact_proc interact_proc;
   Entity_drop_proc drop_proc;
@@ -731,6 +995,18 @@ struct Entity {
   f32 life_time_duration;
   f32 life_timer;
 
+};
+
+struct Entity_cold {
+
+  Gun gun;
+
+  Waypoint_list waypoints;
+  Waypoint     *cur_waypoint;
+
+  s64 door_tiles[8];
+  s64 door_tiles_count;
+
   Sound spawn_sound;
   Sound hurt_sound;
   Sound die_sound;
@@ -742,6 +1018,63 @@ struct Map_data {
   Entity static_entities[MAX_STATIC_ENTITIES];
 };
 
+/*
+ * A replay file is a Replay_header followed by ticks_count Replay_ticks, one
+ * per sim tick. Together with the RNG state at the start of the recording,
+ * that is everything the update reads from outside the game, so playing it
+ * back from a game_reset runs the same session tick for tick.
+ *
+ * That only holds while the update reads nothing that depends on frame timing.
+ * sim_alpha and frame_dt are for drawing and the accumulator, anything the sim
+ * tests against the view goes through sim_view_rect and never cam_view_rect.
+ */
+struct Replay_header {
+  u32 magic;
+  u32 version;
+  f32 sim_dt;
+  s32 screen_width;
+  s32 screen_height;
+  u32 ticks_count;
+  Rng rng[RNG_STREAM_MAX];
+};
+
+struct Replay_tick {
+  Vector2 mouse_offset; /* from the center of the screen, which is what mouse look aims from */
+  s32     key_pressed;
+  u16     input_flags;
+  u16     pad;
+};
+
+struct Replay_chunk {
+  Replay_chunk *next;
+  s64 count;
+  Replay_tick ticks[REPLAY_CHUNK_TICKS];
+};
+
+/*
+ * Hashed uniform grid used as the entity-vs-entity broadphase.
+ * Rebuilt once per update with a counting sort, so the only per entity
+ * storage is a u16 slot index per overlapped cell.
+ */
+struct Spatial_grid {
+  u32 *bucket_start; /* SPATIAL_GRID_BUCKETS+1 offsets into bucket_entities */
+  u16 *bucket_entities;
+  u32  bucket_entities_count;
+
+  u16 *large_entities; /* entities spanning too many cells, tested by every query */
+  u32  large_entities_count;
+
+  u32 *query_stamp; /* per entity slot, dedups entities that span several cells */
+  u32  query_index;
+};
+
+STATIC_ASSERT(MAX_ENTITIES < 65536, entity_index_fits_in_u16);
+STATIC_ASSERT((ENTITY_UID_TABLE_SIZE & (ENTITY_UID_TABLE_SIZE - 1)) == 0, entity_uid_table_size_is_power_of_2);
+STATIC_ASSERT((SPATIAL_GRID_BUCKETS & (SPATIAL_GRID_BUCKETS - 1)) == 0, spatial_grid_buckets_is_power_of_2);
+STATIC_ASSERT(MAX_PARTICLES % SIMD_WIDTH == 0, particle_storage_is_padded_to_simd_width);
+STATIC_ASSERT(MAX_PARTICLES*4 <= 65536, particle_mesh_indices_fit_in_u16);
+STATIC_ASSERT(TILE_COLS % TILE_CHUNK_SIZE == 0 && TILE_ROWS % TILE_CHUNK_SIZE == 0, tile_map_divides_into_chunks);
+
 // TODO level editor
 struct Editor {
   Editor_flags flags;
@@ -757,7 +1090,15 @@ struct Editor {
 
 struct Game {
 
+  /*
+   * The simulation always steps by SIM_DT. Each frame adds its real duration
+   * to sim_accumulator and runs as many ticks as fit, the draw pass then places
+   * things sim_alpha of the way from their previous tick to the current one.
+   */
   f32 dt;
+  f32 frame_dt;
+  f64 sim_accumulator;
+  f32 sim_alpha;
   b32 quit;
 
   Game_state state;
@@ -767,18 +1108,45 @@ struct Game {
   Game_debug_flags debug_flags;
 
   Input_flags input_flags;
+  Vector2 mouse_pos;
   int key_pressed;
   char character_pressed;
 
+  struct {
+    Replay_mode   mode;
+    Arena        *arena;
+    Replay_header header;
+    Replay_chunk *first_chunk;
+    Replay_chunk *last_chunk;
+    Replay_tick  *ticks; /* playback reads the whole file at once */
+    s64           tick_index;
+  } replay;
+
+  struct {
+    Scenario kind;
+    s32      count;
+  } scenario;
+
   u64 frame_index;
+  u64 tick_index;
+
+  u32 collision_counts[COLLISION_COUNTER_MAX];
 
   Arena *main_arena;
   Arena *frame_arena;
   Arena *level_arena;
 
+  /* list nodes live in the level arena, freed ones get reused */
+  Pool entity_node_pool;
+  Pool waypoint_pool;
+
   Font font;
 
+  mu_Context *mu;
+
   Camera2D cam;
+  Rectangle cam_view_rect; /* world space view of cam, set once per frame by camera_update, for drawing only */
+  Rectangle sim_view_rect; /* what the camera sees from the player's simulated pos, set every tick */
 
   struct {
     b32     on;
@@ -801,13 +1169,39 @@ struct Game {
   Texture2D sprite_atlas;
   Texture2D debug_background;
 
+  /*
+   * The tile map is baked into one texel per tile chunk textures that get drawn
+   * scaled up with point filtering. A chunk is only rebaked when a tile in it
+   * changes, or when the tiles being drawn switch between the map and the editor.
+   */
+  Texture2D tile_chunk_textures[TILE_CHUNKS_COUNT];
+  b8 tile_chunk_dirty[TILE_CHUNKS_COUNT];
+  u8 *tile_chunks_source;
+
   u64 entity_uid;
   Entity *entities;
+  Entity_cold *entity_cold;
+  u16 *entity_generation;
+  u16 *entity_uid_table; /* open addressing, uid -> slot+1, 0 is empty */
   u64 entities_allocated;
   Entity *entity_free_list;
 
-  Particle *particles;
-  u64 particles_pos;
+  /* dense lists of live entities, one per order, kept by entity_spawn and entity_die */
+  Slice(Entity_ptr) update_lists[ENTITY_ORDER_MAX];
+  Slice(Entity_ptr) draw_lists[ENTITY_ORDER_MAX];
+
+  Spatial_grid grid;
+
+  Projectile *projectiles;
+  s64 projectiles_count;
+
+  Particle_pool particles;
+
+  Rng rng[RNG_STREAM_MAX];
+
+  /* every visible particle is written into this dynamic mesh and drawn with one call */
+  Mesh     particle_mesh;
+  Material particle_material;
 
   u32 live_entities;
   u32 live_particles;
@@ -868,26 +1262,46 @@ struct Game {
  * function headers
  */
 
-float get_random_float(float min, float max, int steps);
 Collision_manifold tile_segment_intersect(Vector2 p1, Vector2 p2, Vector2 p3, Vector2 p4);
 
 Game* game_init(void);
 void game_load_assets(Game *gp);
 void game_unload_assets(Game *gp);
 void game_update_and_draw(Game *gp);
+void game_update(Game *gp);
+void game_draw(Game *gp);
 void game_close(Game *gp);
 void game_reset(Game *gp);
 void game_main_loop(Game *gp);
 void game_level_end(Game *gp);
+void level_arena_clear(Game *gp);
 
 void game_editor_save_and_close(Game *gp);
 void game_editor_open(Game *gp);
 
+void replay_record_begin(Game *gp);
+b32  replay_playback_begin(Game *gp, char *path);
+void replay_stop(Game *gp);
+void replay_tick_input(Game *gp);
+
+b32 trace_write(Game *gp, char *path);
+
+void scenario_begin(Game *gp, Scenario scenario, s32 count);
+void scenario_tick(Game *gp);
+
+void debug_window(Game *gp);
+
 void camera_shake(Game *gp, float duration, float magnitude);
 void camera_pulsate(Game *gp, float duration, float magnitude);
 
+Camera2D  camera_for_target(Game *gp, Vector2 target);
+void      camera_update(Game *gp);
+Rectangle camera_sim_view_rect(Game *gp);
+
 Entity* entity_spawn(Game *gp);
 void    entity_die(Game *gp, Entity *ep);
+void    entity_set_update_order(Game *gp, Entity *ep, Entity_order order);
+void    entity_set_draw_order(Game *gp, Entity *ep, Entity_order order);
 
 Entity_list* push_entity_list(Game *gp);
 Entity_node* push_entity_list_node(Game *gp);
@@ -900,9 +1314,9 @@ Waypoint* waypoint_list_append(Game *gp, Waypoint_list *list, Vector2 pos, float
 Waypoint* waypoint_list_append_tagged(Game *gp, Waypoint_list *list, Vector2 pos, float radius, u64 tag);
 
 Entity* entity_from_uid(Game *gp, u64 uid);
-Entity* entity_from_handle(Entity_handle handle);
+Entity* entity_from_handle(Game *gp, Entity_handle handle);
 
-Entity_handle handle_from_entity(Entity *ep);
+Entity_handle handle_from_entity(Game *gp, Entity *ep);
 b32 is_valid_handle(Entity_handle handle);
 
 Entity* spawn_player(Game *gp);
@@ -911,6 +1325,7 @@ Entity* spawn_shotgun(Game *gp);
 Entity* spawn_assault_rifle(Game *gp);
 Entity* spawn_door(Game *gp);
 Entity* spawn_key(Game *gp);
+Entity* spawn_raptor(Game *gp);
 
 void pickup_health_pack(Game *gp, Entity *a, Entity *b);
 
@@ -922,13 +1337,26 @@ void drop_gun(Game *gp, Entity *weapon, Entity *wielder);
 
 b32 check_circle_all_inside_rec(Vector2 center, float radius, Rectangle rec);
 
+void emit_particles(Game *gp, Particle_emitter emitter, Vector2 pos, Vector2 vel);
+s64  particle_reserve(Game *gp, s64 n);
+void particles_update(Game *gp);
+void particles_draw(Game *gp);
 void entity_emit_particles(Game *gp, Entity *ep);
 
 void entity_shoot_gun(Game *gp, Entity *ep);
 
+void projectiles_update(Game *gp);
+void projectiles_draw(Game *gp);
+
 b32  entity_check_collision(Game *gp, Entity *a, Entity *b);
+b32  entity_check_swept_collision(Game *gp, Entity *a, Entity *b, float *toi);
+b32  circle_sweep_time_of_impact(Vector2 p0, Vector2 p1, Vector2 center, float radius, float *toi);
+
+void              spatial_grid_build(Game *gp);
+Slice(Entity_ptr) spatial_grid_query(Game *gp, Vector2 pos, float radius);
 
 void draw_sprite(Game *gp, Entity *ep);
+void draw_sprite_frame(Game *gp, Sprite_frame frame, Sprite_flags flags, Vector2 pos, f32 scale, f32 rotation, Color tint);
 void sprite_update(Game *gp, Entity *ep);
 Sprite_frame sprite_current_frame(Sprite sp);
 b32 sprite_at_keyframe(Sprite sp, s32 keyframe);
@@ -940,6 +1368,16 @@ void row_col_from_tile(s64 tile, s64 *row, s64 *col);
 
 s64 tile_distance(s64 a, s64 b);
 
+void tile_set(Game *gp, u8 *tiles, s64 tile, Tile_kind kind);
+void tile_chunks_mark_all_dirty(Game *gp);
+void tile_chunk_bake(Game *gp, u8 *tiles, s64 chunk);
+void tile_chunks_draw(Game *gp, u8 *tiles);
+
+Rectangle camera_view_rect(Camera2D cam);
+float     entity_draw_radius(Entity *ep);
+Vector2   entity_draw_pos(Game *gp, Entity *ep);
+f32       entity_draw_look_angle(Game *gp, Entity *ep);
+
 
 /*
  * entity settings
@@ -958,6 +1396,12 @@ const float PLAYER_SLOW_FACTOR = 0.5f;
 const Color PLAYER_BOUNDS_COLOR = { 255, 0, 0, 255 };
 const float PLAYER_LOOK_RADIUS = 200.0f;
 
+const float RAPTOR_BOUNDS_RADIUS = 10;
+const s32 RAPTOR_HEALTH = 3;
+const float RAPTOR_MIN_SPEED = 120.0f;
+const float RAPTOR_MAX_SPEED = 220.0f;
+const Color RAPTOR_COLOR = { 120, 160, 60, 255 };
+
 const float PICKUP_BOUNDS_RADIUS = 50.0f;
 
 const float WEAPON_INTERACT_RADIUS = 50;
@@ -972,6 +1416,15 @@ ENTITY_FLAG_DIE_ON_TILE_COLLISION |
 ENTITY_FLAG_DYNAMICS |
 0;
 
+/* bullet flags a Projectile can handle, anything else makes the gun spawn entity bullets */
+const Entity_flags PROJECTILE_BULLET_FLAGS =
+DEFAULT_BULLET_FLAGS |
+ENTITY_FLAG_HAS_SPRITE |
+ENTITY_FLAG_EMIT_DEATH_PARTICLES |
+ENTITY_FLAG_APPLY_FRICTION |
+ENTITY_FLAG_HAS_LIFETIME |
+0;
+
 const Entity_kind_mask PLAYER_BULLET_APPLY_COLLISION_MASK =
 ENTITY_KIND_MASK_RAPTOR |
 0;
@@ -1014,6 +1467,8 @@ GAME_DEBUG_FLAG_FREE_CAM |
 
 #include "sprite_data.c"
 
+#include "particle_data.c"
+
 //#include "sound_data.c"
 
 
@@ -1089,7 +1544,102 @@ float boss_shoot_pause = 0;
 #define level_scope_begin() scope_begin(gp->level_arena)
 #define level_scope_end(scope) scope_end(scope)
 
-#define entity_is_part_of_list(ep) (ep->list_node && ep->list_node->ep == ep)
+force_inline u16 entity_slot(Game *gp, Entity *ep) {
+  ASSERT(ep >= gp->entities && ep < gp->entities + MAX_ENTITIES);
+  return (u16)(ep - gp->entities);
+}
+
+force_inline Entity_cold* entity_cold(Game *gp, Entity *ep) {
+  return &gp->entity_cold[entity_slot(gp, ep)];
+}
+
+force_inline b32 entity_is_part_of_list(Game *gp, Entity *ep) {
+  return ep->list_node && entity_from_handle(gp, ep->list_node->handle) == ep;
+}
+
+force_inline u32 entity_uid_hash(u64 uid) {
+  return (u32)((uid * 11400714819323198485ull) >> 32) & (ENTITY_UID_TABLE_SIZE - 1);
+}
+
+void entity_uid_table_insert(Game *gp, Entity *ep) {
+  u16 *table = gp->entity_uid_table;
+  u32 i = entity_uid_hash(ep->uid);
+
+  while(table[i]) {
+    i = (i + 1) & (ENTITY_UID_TABLE_SIZE - 1);
+  }
+
+  table[i] = entity_slot(gp, ep) + 1;
+}
+
+void entity_uid_table_remove(Game *gp, Entity *ep) {
+  u16 *table = gp->entity_uid_table;
+  u16 value = entity_slot(gp, ep) + 1;
+  u32 i = entity_uid_hash(ep->uid);
+
+  while(table[i] != value) {
+    ASSERT(table[i]);
+    i = (i + 1) & (ENTITY_UID_TABLE_SIZE - 1);
+  }
+
+  /* backward shift deletion, keeps probe chains intact without tombstones */
+  for(u32 j = (i + 1) & (ENTITY_UID_TABLE_SIZE - 1); table[j]; j = (j + 1) & (ENTITY_UID_TABLE_SIZE - 1)) {
+    u32 home = entity_uid_hash(gp->entities[table[j] - 1].uid);
+
+    b32 home_is_between = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+
+    if(!home_is_between) {
+      table[i] = table[j];
+      i = j;
+    }
+  }
+
+  table[i] = 0;
+}
+
+force_inline void entity_update_list_push(Game *gp, Entity *ep) {
+  Slice(Entity_ptr) *list = &gp->update_lists[ep->update_order];
+  ASSERT(list->count < MAX_ENTITIES);
+  ep->update_list_index = (s32)list->count;
+  list->d[list->count++] = ep;
+}
+
+force_inline void entity_update_list_remove(Game *gp, Entity *ep) {
+  Slice(Entity_ptr) *list = &gp->update_lists[ep->update_order];
+  ASSERT(list->d[ep->update_list_index] == ep);
+  Entity *last = list->d[--list->count];
+  list->d[ep->update_list_index] = last;
+  last->update_list_index = ep->update_list_index;
+}
+
+force_inline void entity_draw_list_push(Game *gp, Entity *ep) {
+  Slice(Entity_ptr) *list = &gp->draw_lists[ep->draw_order];
+  ASSERT(list->count < MAX_ENTITIES);
+  ep->draw_list_index = (s32)list->count;
+  list->d[list->count++] = ep;
+}
+
+force_inline void entity_draw_list_remove(Game *gp, Entity *ep) {
+  Slice(Entity_ptr) *list = &gp->draw_lists[ep->draw_order];
+  ASSERT(list->d[ep->draw_list_index] == ep);
+  Entity *last = list->d[--list->count];
+  list->d[ep->draw_list_index] = last;
+  last->draw_list_index = ep->draw_list_index;
+}
+
+void entity_set_update_order(Game *gp, Entity *ep, Entity_order order) {
+  if(ep->update_order == order) return;
+  entity_update_list_remove(gp, ep);
+  ep->update_order = order;
+  entity_update_list_push(gp, ep);
+}
+
+void entity_set_draw_order(Game *gp, Entity *ep, Entity_order order) {
+  if(ep->draw_order == order) return;
+  entity_draw_list_remove(gp, ep);
+  ep->draw_order = order;
+  entity_draw_list_push(gp, ep);
+}
 
 Entity *entity_spawn(Game *gp) {
   Entity *ep = 0;
@@ -1111,21 +1661,52 @@ Entity *entity_spawn(Game *gp) {
       .uid = gp->entity_uid,
     };
 
+  *entity_cold(gp, ep) = (Entity_cold){0};
+
+  ep->update_order = ENTITY_ORDER_FIRST;
+  ep->draw_order = ENTITY_ORDER_FIRST;
+  entity_update_list_push(gp, ep);
+  entity_draw_list_push(gp, ep);
+
+  u16 slot = entity_slot(gp, ep);
+  if(gp->entity_generation[slot] == 0) {
+    gp->entity_generation[slot] = 1;
+  }
+
+  entity_uid_table_insert(gp, ep);
+
   return ep;
 }
 
 void entity_die(Game *gp, Entity *ep) {
+  b32 was_part_of_list = entity_is_part_of_list(gp, ep);
+
+  u16 slot = entity_slot(gp, ep);
+  gp->entity_generation[slot]++;
+  if(gp->entity_generation[slot] == 0) {
+    gp->entity_generation[slot] = 1;
+  }
+
+  entity_uid_table_remove(gp, ep);
+
+  entity_update_list_remove(gp, ep);
+  entity_draw_list_remove(gp, ep);
+
   ep->free_list_next = gp->entity_free_list;
   gp->entity_free_list = ep;
   ep->live = 0;
 
-  if(entity_is_part_of_list(ep)) {
+  if(was_part_of_list) {
     ASSERT(ep->parent_list);
     Entity_list *list = ep->parent_list;
     list->count--;
     dll_remove(list->first, list->last, ep->list_node);
+    pool_free(&gp->entity_node_pool, ep->list_node);
   }
 
+  ep->list_node = 0;
+  ep->parent_list = 0;
+
 }
 
 force_inline Entity_list* push_entity_list(Game *gp) {
@@ -1134,7 +1715,7 @@ force_inline Entity_list* push_entity_list(Game *gp) {
 }
 
 force_inline Entity_node* push_entity_list_node(Game *gp) {
-  Entity_node *e_node = push_array(gp->level_arena, Entity_node, 1);
+  Entity_node *e_node = pool_push(&gp->entity_node_pool, Entity_node);
   return e_node;
 }
 
@@ -1143,8 +1724,7 @@ Entity_node* entity_list_append(Game *gp, Entity_list *list, Entity *ep) {
 
   Entity_node *e_node = push_entity_list_node(gp);
 
-  e_node->uid = ep->uid;
-  e_node->ep = ep;
+  e_node->handle = handle_from_entity(gp, ep);
 
   ep->parent_list = list;
   ep->list_node = e_node;
@@ -1160,8 +1740,10 @@ Entity_node* entity_list_push_front(Game *gp, Entity_list *list, Entity *ep) {
 
   Entity_node *e_node = push_entity_list_node(gp);
 
-  e_node->uid = ep->uid;
-  e_node->ep = ep;
+  e_node->handle = handle_from_entity(gp, ep);
+
+  ep->parent_list = list;
+  ep->list_node = e_node;
 
   dll_push_front(list->first, list->last, e_node);
   list->count++;
@@ -1169,58 +1751,56 @@ Entity_node* entity_list_push_front(Game *gp, Entity_list *list, Entity *ep) {
   return e_node;
 }
 
+/* an entity is in at most one list and knows its node, so this doesn't walk the list */
 b32 entity_list_remove(Game *gp, Entity_list *list, Entity *ep) {
   ASSERT(list);
 
-  Entity_node *found = 0;
-
-  for(Entity_node *node = list->first; node; node = node->next) {
-    if(node->ep == ep) {
-      found = node;
-      break;
-    }
-  }
+  b32 found = ep->parent_list == list && entity_is_part_of_list(gp, ep);
 
   if(found) {
-    dll_remove(list->first, list->last, found);
-  }
+    dll_remove(list->first, list->last, ep->list_node);
+    pool_free(&gp->entity_node_pool, ep->list_node);
+    list->count--;
 
-  list->count--;
+    ep->list_node = 0;
+    ep->parent_list = 0;
+  }
 
-  return (b32)(!!found);
+  return found;
 }
 
 Entity* entity_from_uid(Game *gp, u64 uid) {
   Entity *ep = 0;
 
-  for(int i = 0; i < gp->entities_allocated; i++) {
-    if(gp->entities[i].uid == uid) {
-      ep = gp->entities + i;
-      break;
-    }
+  if(uid == 0) {
+    return ep;
   }
 
-  return ep;
-}
-
-Entity* entity_from_handle(Entity_handle handle) {
-  Entity *ep = 0;
+  u16 *table = gp->entity_uid_table;
 
-  if(handle.ep) {
-    if(handle.ep->uid == handle.uid) {
-      ep = handle.ep;
+  for(u32 i = entity_uid_hash(uid); table[i]; i = (i + 1) & (ENTITY_UID_TABLE_SIZE - 1)) {
+    Entity *candidate = &gp->entities[table[i] - 1];
+    if(candidate->uid == uid) {
+      ep = candidate;
+      break;
     }
   }
 
   return ep;
 }
 
-Entity_handle handle_from_entity(Entity *ep) {
-  return (Entity_handle){ .uid = ep->uid, .ep = ep };
+force_inline Entity* entity_from_handle(Game *gp, Entity_handle handle) {
+  b32 valid = (handle.generation != 0) & (gp->entity_generation[handle.slot] == handle.generation);
+  return valid ? &gp->entities[handle.slot] : 0;
+}
+
+force_inline Entity_handle handle_from_entity(Game *gp, Entity *ep) {
+  u16 slot = entity_slot(gp, ep);
+  return (Entity_handle){ .slot = slot, .generation = gp->entity_generation[slot] };
 }
 
 force_inline b32 is_valid_handle(Entity_handle handle) {
-  return (handle.uid > 0);
+  return (handle.generation > 0);
 }
 
 force_inline Waypoint* waypoint_list_append(Game *gp, Waypoint_list *list, Vector2 pos, float radius) {
@@ -1228,7 +1808,7 @@ force_inline Waypoint* waypoint_list_append(Game *gp, Waypoint_list *list, Vecto
 }
 
 Waypoint* waypoint_list_append_tagged(Game *gp, Waypoint_list *list, Vector2 pos, float radius, u64 tag) {
-  Waypoint *wp = push_array_no_zero(gp->level_arena, Waypoint, 1);
+  Waypoint *wp = pool_push_no_zero(&gp->waypoint_pool, Waypoint);
   wp->pos = pos;
   wp->radius = radius;
   wp->tag = tag;
@@ -1258,8 +1838,8 @@ Entity* spawn_player(Game *gp) {
     ENTITY_FLAG_EMIT_DEATH_PARTICLES |
     0;
 
-  ep->update_order = ENTITY_ORDER_LAST;
-  ep->draw_order = ENTITY_ORDER_LAST;
+  entity_set_update_order(gp, ep, ENTITY_ORDER_LAST);
+  entity_set_draw_order(gp, ep, ENTITY_ORDER_LAST);
 
   ep->look_dir = PLAYER_LOOK_DIR;
 #ifdef DEBUG
@@ -1303,8 +1883,8 @@ Entity* spawn_shotgun(Game *gp) {
     ENTITY_FLAG_HAS_SPRITE |
     0;
 
-  ep->update_order = ENTITY_ORDER_LAST;
-  ep->draw_order = ENTITY_ORDER_FIRST;
+  entity_set_update_order(gp, ep, ENTITY_ORDER_LAST);
+  entity_set_draw_order(gp, ep, ENTITY_ORDER_FIRST);
 
   // nocheckin
   ep->pos = (Vector2){ .x = 100, . y = 900 }; 
@@ -1318,7 +1898,7 @@ Entity* spawn_shotgun(Game *gp) {
 
   ep->control = ENTITY_CONTROL_GUN_ON_GROUND;
 
-  ep->gun.kind = GUN_KIND_SHOTGUN;
+  entity_cold(gp, ep)->gun.kind = GUN_KIND_SHOTGUN;
 
   ep->death_particle_emitter = PARTICLE_EMITTER_WEAPON_DIE_PUFF;
 
@@ -1347,8 +1927,8 @@ Entity* spawn_assault_rifle(Game *gp) {
     ENTITY_FLAG_HAS_SPRITE |
     0;
 
-  ep->update_order = ENTITY_ORDER_LAST;
-  ep->draw_order = ENTITY_ORDER_FIRST;
+  entity_set_update_order(gp, ep, ENTITY_ORDER_LAST);
+  entity_set_draw_order(gp, ep, ENTITY_ORDER_FIRST);
 
   // nocheckin
   ep->pos = (Vector2){ .x = 500, . y = 900 }; 
@@ -1362,7 +1942,7 @@ Entity* spawn_assault_rifle(Game *gp) {
 
   ep->control = ENTITY_CONTROL_GUN_ON_GROUND;
 
-  ep->gun.kind = GUN_KIND_ASSAULT_RIFLE;
+  entity_cold(gp, ep)->gun.kind = GUN_KIND_ASSAULT_RIFLE;
 
   ep->death_particle_emitter = PARTICLE_EMITTER_WEAPON_DIE_PUFF;
 
@@ -1393,11 +1973,12 @@ Entity* spawn_health_pack(Game *gp) {
     ENTITY_FLAG_EMIT_DEATH_PARTICLES |
     0;
 
-  ep->update_order = ENTITY_ORDER_FIRST;
-  ep->draw_order = ENTITY_ORDER_FIRST;
+  entity_set_update_order(gp, ep, ENTITY_ORDER_FIRST);
+  entity_set_draw_order(gp, ep, ENTITY_ORDER_FIRST);
 
-  ep->pos = (Vector2){ .x = (float)GetRandomValue(200, WINDOW_WIDTH-200), . y = -0.4*WINDOW_HEIGHT }; 
-  ep->vel = (Vector2){ .y = (float)GetRandomValue(780, 800), };
+  Rng *rng = &gp->rng[RNG_STREAM_GAMEPLAY];
+  ep->pos = (Vector2){ .x = (float)rng_range_s32(rng, 200, WINDOW_WIDTH-200), . y = -0.4*WINDOW_HEIGHT }; 
+  ep->vel = (Vector2){ .y = (float)rng_range_s32(rng, 780, 800), };
   ep->friction = 0.45f;
 
   ep->collide_proc = pickup_health_pack;
@@ -1432,16 +2013,17 @@ Entity* spawn_door(Game *gp) {
 
   ep->pos = Vector2AddValue(point_from_tile(arr_last(editor->selected_door_tiles)), (float)TILE_SIZE*0.5f);
 
-  ep->door_tiles_count = editor->selected_door_tiles.count;
+  Entity_cold *cold = entity_cold(gp, ep);
+  cold->door_tiles_count = editor->selected_door_tiles.count;
   for(int i = 0; i < editor->selected_door_tiles.count; i++) {
-    ep->door_tiles[i] = editor->selected_door_tiles.d[i];
+    cold->door_tiles[i] = editor->selected_door_tiles.d[i];
   }
 
   editor->selected_door_tiles.count = 0;
 
   ep->control = ENTITY_CONTROL_DOOR;
-  ep->update_order = ENTITY_ORDER_LAST;
-  ep->draw_order = ENTITY_ORDER_LAST;
+  entity_set_update_order(gp, ep, ENTITY_ORDER_LAST);
+  entity_set_draw_order(gp, ep, ENTITY_ORDER_LAST);
 
   ep->bounds_color = YELLOW;
   ep->radius = 20;
@@ -1469,8 +2051,8 @@ Entity* spawn_key(Game *gp) {
     ENTITY_FLAG_HAS_SPRITE |
     0;
 
-  ep->update_order = ENTITY_ORDER_LAST;
-  ep->draw_order = ENTITY_ORDER_FIRST;
+  entity_set_update_order(gp, ep, ENTITY_ORDER_LAST);
+  entity_set_draw_order(gp, ep, ENTITY_ORDER_FIRST);
 
   // nocheckin
   ep->pos = (Vector2){ .x = 500, . y = 900 }; 
@@ -1502,6 +2084,41 @@ Entity* spawn_key(Game *gp) {
   return ep;
 }
 
+/* no sprite yet, raptors draw as filled bounds and chase the player */
+Entity* spawn_raptor(Game *gp) {
+  Entity *ep = entity_spawn(gp);
+
+  ep->kind = ENTITY_KIND_RAPTOR;
+  ep->control = ENTITY_CONTROL_FOLLOW_PARENT;
+
+  ep->flags =
+    ENTITY_FLAG_DYNAMICS |
+    ENTITY_FLAG_CONTINUOUS_TILE_COLLISION |
+    ENTITY_FLAG_RECEIVE_COLLISION |
+    ENTITY_FLAG_RECEIVE_COLLISION_DAMAGE |
+    ENTITY_FLAG_EMIT_DEATH_PARTICLES |
+    ENTITY_FLAG_FILL_BOUNDS |
+    0;
+
+  entity_set_update_order(gp, ep, ENTITY_ORDER_FIRST);
+  entity_set_draw_order(gp, ep, ENTITY_ORDER_FIRST);
+
+  ASSERT(is_valid_handle(gp->player_handle));
+  ep->parent_handle = gp->player_handle;
+  ep->scalar_vel = rng_range_f32(&gp->rng[RNG_STREAM_AI], RAPTOR_MIN_SPEED, RAPTOR_MAX_SPEED);
+
+  ep->health = RAPTOR_HEALTH;
+
+  ep->death_particle_emitter = PARTICLE_EMITTER_BLOOD_PUFF;
+
+  ep->bounds_color = RAPTOR_COLOR;
+  ep->fill_color = RAPTOR_COLOR;
+
+  ep->radius = RAPTOR_BOUNDS_RADIUS;
+
+  return ep;
+}
+
 void pickup_key(Game *gp, Entity *a, Entity *b) {
 
   ASSERT(a->kind == ENTITY_KIND_KEY);
@@ -1526,7 +2143,7 @@ void pickup_gun(Game *gp, Entity *a, Entity *b) {
   Entity *player = b;
 
   {
-    Entity *holding = entity_from_handle(player->child_handle);
+    Entity *holding = entity_from_handle(gp, player->child_handle);
 
     if(holding) {
       holding->drop_proc(gp, holding, player);
@@ -1538,9 +2155,10 @@ void pickup_gun(Game *gp, Entity *a, Entity *b) {
     ENTITY_FLAG_IS_INTERACTABLE |
     ENTITY_FLAG_MANUAL_SPRITE_ORIGIN |
     0;
+  gun->flags |= ENTITY_FLAG_FOLLOW_HOLDER;
 
-  gun->parent_handle = handle_from_entity(player);
-  player->holding_gun_handle = handle_from_entity(gun);
+  gun->parent_handle = handle_from_entity(gp, player);
+  player->holding_gun_handle = handle_from_entity(gp, gun);
 
   gun->sprite = gun->top_view_sprite;
   gun->control = ENTITY_CONTROL_GUN_BEING_HELD;
@@ -1553,6 +2171,7 @@ void drop_gun(Game *gp, Entity *weapon, Entity *wielder) {
   weapon->flags |=
     ENTITY_FLAG_IS_INTERACTABLE |
     0;
+  weapon->flags &= ~ENTITY_FLAG_FOLLOW_HOLDER;
 
   weapon->parent_handle = (Entity_handle){0};
   wielder->child_handle = (Entity_handle){0};
@@ -1597,6 +2216,57 @@ void camera_shake(Game *gp, float duration, float magnitude) {
 
 }
 
+/*
+ * gp->cam centered on the screen and following target with the shake and pulsate
+ * in effect. Outside the free cam, and only while there's a player to follow.
+ */
+Camera2D camera_for_target(Game *gp, Vector2 target) {
+  Camera2D cam = gp->cam;
+
+  cam.offset = (Vector2){ WINDOW_WIDTH*0.5f, WINDOW_HEIGHT*0.5f };
+
+  if(!(gp->debug_flags & GAME_DEBUG_FLAG_FREE_CAM)) {
+
+    if(gp->player) {
+      cam.target = target;
+
+      if(gp->flags & GAME_FLAG_CAMERA_SHAKE) {
+        cam.target = Vector2Add(cam.target, gp->cam_shake.offset);
+      }
+
+      if(gp->flags & GAME_FLAG_CAMERA_PULSATE) {
+        cam.zoom = gp->cam_pulsate.save_zoom - gp->cam_pulsate.zoom_offset;
+      }
+
+    }
+
+  }
+
+  return cam;
+}
+
+/*
+ * Places the camera for this frame's draw and caches the world space rectangle
+ * it sees. The target is interpolated by sim_alpha, so only drawing may cull
+ * against cam_view_rect, the simulation reads sim_view_rect.
+ */
+void camera_update(Game *gp) {
+  Vector2 target = gp->player ? entity_draw_pos(gp, gp->player) : gp->cam.target;
+
+  gp->cam = camera_for_target(gp, target);
+  gp->cam_view_rect = camera_view_rect(gp->cam);
+}
+
+/*
+ * The camera_update view from where the player is this tick rather than where it
+ * gets drawn, so on screen tests in the simulation don't depend on frame timing.
+ */
+Rectangle camera_sim_view_rect(Game *gp) {
+  Vector2 target = gp->player ? gp->player->pos : gp->cam.target;
+
+  return camera_view_rect(camera_for_target(gp, target));
+}
+
 void camera_pulsate(Game *gp, float duration, float magnitude) {
 
   gp->flags |= GAME_FLAG_CAMERA_PULSATE;
@@ -1624,312 +2294,234 @@ b32 check_circle_all_inside_rec(Vector2 center, float radius, Rectangle rec) {
   return inside;
 }
 
-force_inline float get_random_float(float min, float max, int steps) {
-  int val = GetRandomValue(0, steps);
-  float result = Remap((float)val, 0.0f, (float)steps, min, max);
-  return result;
-}
-
-void entity_emit_particles(Game *gp, Entity *ep) {
-
-  Particle_emitter emitter = ep->particle_emitter;
-
-  Particle buf[MAX_PARTICLES];
-  s32 n_particles = 0;
-
-  switch(emitter) {
-    default:
-      UNREACHABLE;
-    case PARTICLE_EMITTER_BIG_PLANE_EXPLOSION:
-      {
-        Color tints[] = {
-          YELLOW, ORANGE, RED, ColorAlpha(RED, 0.8f),
-        };
-        int amounts[] = { 300, 200, 40 };
-
-        int base = 0;
-        for(int ti = 0; ti < ARRLEN(tints)-1; ti++) {
-
-          n_particles += GetRandomValue(amounts[ti], amounts[ti]+20);
-          ASSERT(n_particles <= MAX_PARTICLES);
-
-          int i = base;
-          for(; i < n_particles; i++) {
-            Particle *p = buf + i;
-            *p = (Particle){0};
-
-            p->lifetime = get_random_float(TARGET_FRAME_TIME * 20, TARGET_FRAME_TIME * 30, 5);
-
-            p->pos = ep->pos;
-            p->vel =
-              Vector2Rotate((Vector2){ 0, -1 },
-                  get_random_float(0, 2*PI, 150));
-
-            p->vel = Vector2Scale(p->vel, (float)GetRandomValue(400, 700));
-
-            p->radius = get_random_float(2.9f, 4.7f, 15);
-            p->shrink = (0.6*p->radius)/p->lifetime;
+void emit_particles(Game *gp, Particle_emitter emitter, Vector2 pos, Vector2 vel) {
+  ASSERT(emitter > PARTICLE_EMITTER_INVALID && emitter < PARTICLE_EMITTER_MAX);
 
-            p->friction = (float)GetRandomValue(0, 2);
+  Particle_pool *pool = &gp->particles;
+  Rng *rng = &gp->rng[RNG_STREAM_PARTICLES];
+  Particle_emitter_def def = __particle_emitters[emitter];
 
-            p->begin_tint = tints[ti];
-            p->end_tint = tints[ti+1];
+  for(s32 burst_i = 0; burst_i < def.bursts_count; burst_i++) {
+    Particle_burst burst = __particle_bursts[def.first_burst + burst_i];
 
-          }
-          base = i;
-        }
-
-      } break;
-    case PARTICLE_EMITTER_WHITE_PUFF:
-      {
-        n_particles = GetRandomValue(100, 110);
-        ASSERT(n_particles <= MAX_PARTICLES);
-
-        for(int i = 0; i < n_particles; i++) {
-          Particle *p = buf + i;
-          *p = (Particle){0};
-
-          p->lifetime = get_random_float(TARGET_FRAME_TIME * 20, TARGET_FRAME_TIME * 26, 10);
-
-          p->pos = ep->pos;
-          p->vel =
-            Vector2Rotate((Vector2){ 0, -1 },
-                get_random_float(0, 2*PI, 150));
-
-          p->vel = Vector2Scale(p->vel, (float)GetRandomValue(1400, 1500));
-
-          p->radius = get_random_float(2.0f, 4.0f, 5);
-          p->shrink = (0.5*p->radius)/p->lifetime;
-
-          p->friction = (float)GetRandomValue(8, 15);
-
-          p->begin_tint = RAYWHITE;
-          p->end_tint = ColorAlpha(p->begin_tint, 0.8);
-
-        }
-
-      } break;
-    case PARTICLE_EMITTER_WEAPON_DIE_PUFF:
-      {
-        n_particles = GetRandomValue(10, 15);
-        ASSERT(n_particles <= MAX_PARTICLES);
-
-        for(int i = 0; i < n_particles; i++) {
-          Particle *p = buf + i;
-          *p = (Particle){0};
-
-          p->lifetime = get_random_float(TARGET_FRAME_TIME * 30, TARGET_FRAME_TIME * 40, 10);
-
-          p->pos = ep->pos;
-          p->vel =
-            Vector2Rotate((Vector2){ 0, -1 },
-                get_random_float(0, 2*PI, 150));
-
-          p->vel = Vector2Scale(p->vel, (float)GetRandomValue(80, 90));
-
-          p->radius = get_random_float(0.9f, 1.7f, 4);
-          p->shrink = (0.46*p->radius)/p->lifetime;
-
-
-          p->friction = get_random_float(0.05f, 0.1f, 4);
-
-          p->begin_tint = (Color){ 58, 58, 58, 255 };
-          p->end_tint = ColorAlpha(p->begin_tint, 0.8);
-
-        }
-
-      } break;
-    case PARTICLE_EMITTER_BROWN_PUFF:
-      {
-        n_particles = GetRandomValue(10, 15);
-        ASSERT(n_particles <= MAX_PARTICLES);
-
-        for(int i = 0; i < n_particles; i++) {
-          Particle *p = buf + i;
-          *p = (Particle){0};
-
-          p->lifetime = get_random_float(TARGET_FRAME_TIME * 30, TARGET_FRAME_TIME * 40, 10);
+    s64 n_particles = rng_range_s32(rng, burst.count_min, burst.count_max);
+    s64 first = particle_reserve(gp, n_particles);
 
-          p->pos = ep->pos;
-          p->vel =
-            Vector2Rotate((Vector2){ 0, -1 },
-                get_random_float(0, 2*PI, 150));
-
-          p->vel = Vector2Scale(p->vel, (float)GetRandomValue(80, 90));
-
-          p->radius = get_random_float(2.9f, 3.5f, 4);
-          p->shrink = (0.36*p->radius)/p->lifetime;
-
-
-          p->friction = get_random_float(0.05f, 0.1f, 4);
-
-          p->begin_tint = (Color){ 102, 57, 49, 255 };
-          p->end_tint = ColorAlpha(p->begin_tint, 0.8);
-
-        }
-
-      } break;
-    case PARTICLE_EMITTER_GREEN_PUFF:
-      {
-        n_particles = GetRandomValue(10, 15);
-        ASSERT(n_particles <= MAX_PARTICLES);
-
-        for(int i = 0; i < n_particles; i++) {
-          Particle *p = buf + i;
-          *p = (Particle){0};
-
-          p->lifetime = get_random_float(TARGET_FRAME_TIME * 30, TARGET_FRAME_TIME * 40, 10);
-
-          p->pos = ep->pos;
-          p->vel =
-            Vector2Rotate((Vector2){ 0, -1 },
-                get_random_float(0, 2*PI, 150));
-
-          p->vel = Vector2Scale(p->vel, (float)GetRandomValue(80, 90));
-
-          p->radius = get_random_float(2.9f, 3.5f, 4);
-          p->shrink = (0.36*p->radius)/p->lifetime;
-
-
-          p->friction = get_random_float(0.05f, 0.1f, 4);
-
-          p->begin_tint = (Color){ 0, 255, 0, 255 };
-          p->end_tint = ColorAlpha(p->begin_tint, 0.8);
-
-        }
-
-      } break;
-    case PARTICLE_EMITTER_MASSIVE_BLOOD_PUFF:
-      {
-        n_particles = GetRandomValue(1100, 1300);
-        ASSERT(n_particles <= MAX_PARTICLES);
-
-        for(int i = 0; i < n_particles; i++) {
-          Particle *p = buf + i;
-          *p = (Particle){0};
-
-          p->lifetime = get_random_float(TARGET_FRAME_TIME * 20, TARGET_FRAME_TIME * 30, 5);
-
-          p->pos = ep->pos;
-          p->vel =
-            Vector2Rotate((Vector2){ 0, -1 },
-                get_random_float(0, 2*PI, 150));
-
-          p->vel = Vector2Scale(p->vel, (float)GetRandomValue(400, 600));
-
-          p->radius = get_random_float(3.7f, 4.6f, 10);
-          p->shrink = (0.7*p->radius)/p->lifetime;
-
-          p->friction = (float)GetRandomValue(0, 2);
+    /* a still emitter aiming against its velocity has nowhere to aim, its particles don't move */
+    Vector2 aim = { 0, -1 };
+    if(burst.aim_against_vel) {
+      aim = Vector2Normalize(Vector2Negate(vel));
+    }
+    f32 aim_angle = atan2f(aim.y, aim.x);
+    f32 aim_scale = Vector2Length(aim);
+
+    for(s64 chunk_first = 0; chunk_first < n_particles; chunk_first += PARTICLE_SPAWN_CHUNK) {
+      s64 chunk_count = MIN(PARTICLE_SPAWN_CHUNK, n_particles - chunk_first);
+
+      f32 r_lifetime[PARTICLE_SPAWN_CHUNK];
+      f32 r_angle[PARTICLE_SPAWN_CHUNK];
+      f32 r_speed[PARTICLE_SPAWN_CHUNK];
+      f32 r_radius[PARTICLE_SPAWN_CHUNK];
+      f32 r_friction[PARTICLE_SPAWN_CHUNK];
+
+      rng_fill_f32(rng, r_lifetime, chunk_count);
+      rng_fill_f32(rng, r_angle, chunk_count);
+      rng_fill_f32(rng, r_speed, chunk_count);
+      rng_fill_f32(rng, r_radius, chunk_count);
+      rng_fill_f32(rng, r_friction, chunk_count);
+
+      for(s64 i = 0; i < chunk_count; i++) {
+        s64 j = first + chunk_first + i;
+
+        f32 lifetime = Lerp(burst.lifetime_min, burst.lifetime_max, r_lifetime[i]);
+        f32 angle    = aim_angle + burst.spread * (2.0f*r_angle[i] - 1.0f);
+        f32 speed    = aim_scale * Lerp(burst.speed_min, burst.speed_max, r_speed[i]);
+        f32 radius   = Lerp(burst.radius_min, burst.radius_max, r_radius[i]);
+
+        pool->pos_x[j]      = pos.x;
+        pool->pos_y[j]      = pos.y;
+        pool->vel_x[j]      = cosf(angle) * speed;
+        pool->vel_y[j]      = sinf(angle) * speed;
+        pool->radius[j]     = radius;
+        pool->shrink[j]     = burst.shrink_rate + (burst.shrink * radius) / lifetime;
+        pool->friction[j]   = Lerp(burst.friction_min, burst.friction_max, r_friction[i]);
+        pool->live[j]       = 0;
+        pool->lifetime[j]   = lifetime;
+        pool->begin_tint[j] = burst.begin_tint;
+        pool->end_tint[j]   = burst.end_tint;
+      }
 
-          p->begin_tint = BLOOD;
-          p->end_tint = ColorAlpha(BLOOD, 0.75f);
+    }
 
-        }
+  }
 
-      } break;
-    case PARTICLE_EMITTER_BLOOD_PUFF:
-      {
-        n_particles = GetRandomValue(200, 210);
-        ASSERT(n_particles <= MAX_PARTICLES);
+}
 
-        for(int i = 0; i < n_particles; i++) {
-          Particle *p = buf + i;
-          *p = (Particle){0};
+/*
+ * Reserves n contiguous particles at the end of the live range and returns the
+ * index of the first one, emitters write straight into them. If the pool can't
+ * fit the whole burst the oldest particles are evicted to make room, they sit at
+ * the front of the live range so that's one move per field.
+ */
+s64 particle_reserve(Game *gp, s64 n) {
+  Particle_pool *pool = &gp->particles;
 
-          p->lifetime = get_random_float(TARGET_FRAME_TIME * 20, TARGET_FRAME_TIME * 25, 5);
+  ASSERT(n >= 0 && n <= MAX_PARTICLES);
 
-          p->pos = ep->pos;
-          p->vel =
-            Vector2Rotate((Vector2){ 0, -1 },
-                get_random_float(0, 2*PI, 150));
+  s64 evict = pool->count + n - MAX_PARTICLES;
 
-          p->vel = Vector2Scale(p->vel, (float)GetRandomValue(500, 600));
+  if(evict > 0) {
+    s64 keep = pool->count - evict;
 
-          p->radius = get_random_float(2.7f, 3.2f, 3);
-          p->shrink = (0.7*p->radius)/p->lifetime;
+#define X(type, field) memory_copy(pool->field, pool->field + evict, sizeof(type) * keep);
+    PARTICLE_POOL_FIELDS
+#undef X
 
-          p->friction = (float)GetRandomValue(0, 2);
+    pool->count = keep;
+  }
 
-          p->begin_tint = BLOOD;
-          p->end_tint = ColorAlpha(BLOOD, 0.75f);
+  s64 first = pool->count;
+  pool->count += n;
 
-        }
+  return first;
+}
 
-      } break;
-    case PARTICLE_EMITTER_SPARKS:
-      {
-        n_particles = GetRandomValue(2, 10);
-        ASSERT(n_particles <= MAX_PARTICLES);
+void particles_update(Game *gp) {
+  Particle_pool *pool = &gp->particles;
+  s64 count = pool->count;
+
+  { /* integrate */
+
+    Rectangle view = gp->sim_view_rect;
+
+    F32x4 dt = f32x4_set1(gp->dt);
+    F32x4 zero = f32x4_set1(0);
+    F32x4 view_x0 = f32x4_set1(view.x);
+    F32x4 view_y0 = f32x4_set1(view.y);
+    F32x4 view_x1 = f32x4_set1(view.x + view.width);
+    F32x4 view_y1 = f32x4_set1(view.y + view.height);
+
+    /* storage is padded to SIMD_WIDTH so the tail lanes past count are safe to touch */
+    for(s64 i = 0; i < count; i += SIMD_WIDTH) {
+      F32x4 pos_x    = f32x4_load(pool->pos_x + i);
+      F32x4 pos_y    = f32x4_load(pool->pos_y + i);
+      F32x4 vel_x    = f32x4_load(pool->vel_x + i);
+      F32x4 vel_y    = f32x4_load(pool->vel_y + i);
+      F32x4 radius   = f32x4_load(pool->radius + i);
+      F32x4 shrink   = f32x4_load(pool->shrink + i);
+      F32x4 friction = f32x4_load(pool->friction + i);
+      F32x4 live     = f32x4_load(pool->live + i);
+      F32x4 lifetime = f32x4_load(pool->lifetime + i);
+
+      /* particles that aren't in view any more are killed before they move, same as entities */
+      F32x4 dx = f32x4_sub(pos_x, f32x4_min(f32x4_max(pos_x, view_x0), view_x1));
+      F32x4 dy = f32x4_sub(pos_y, f32x4_min(f32x4_max(pos_y, view_y0), view_y1));
+      F32x4 in_view = f32x4_cmp_le(f32x4_add(f32x4_mul(dx, dx), f32x4_mul(dy, dy)), f32x4_mul(radius, radius));
+
+      F32x4 alive = f32x4_and(f32x4_cmp_lt(live, lifetime), in_view);
+
+      pos_x = f32x4_add(pos_x, f32x4_mul(vel_x, dt));
+      pos_y = f32x4_add(pos_y, f32x4_mul(vel_y, dt));
+
+      F32x4 drag = f32x4_mul(friction, dt);
+      vel_x = f32x4_sub(vel_x, f32x4_mul(vel_x, drag));
+      vel_y = f32x4_sub(vel_y, f32x4_mul(vel_y, drag));
+
+      radius = f32x4_select(f32x4_cmp_lt(zero, radius), f32x4_sub(radius, f32x4_mul(shrink, dt)), radius);
+
+      live = f32x4_add(live, dt);
+      lifetime = f32x4_select(alive, lifetime, zero);
+
+      f32x4_store(pool->pos_x + i, pos_x);
+      f32x4_store(pool->pos_y + i, pos_y);
+      f32x4_store(pool->vel_x + i, vel_x);
+      f32x4_store(pool->vel_y + i, vel_y);
+      f32x4_store(pool->radius + i, radius);
+      f32x4_store(pool->live + i, live);
+      f32x4_store(pool->lifetime + i, lifetime);
+    }
 
-        for(int i = 0; i < n_particles; i++) {
-          Particle *p = buf + i;
-          *p = (Particle){0};
+  } /* integrate */
 
-          p->lifetime = get_random_float(TARGET_FRAME_TIME * 17, TARGET_FRAME_TIME * 20, 3);
+  { /* compact */
 
-          p->pos = ep->pos;
-          p->vel =
-            Vector2Rotate(Vector2Normalize(Vector2Negate(ep->vel)),
-                get_random_float(-PI*0.4f, PI*0.4f, 1000));
+    s64 live_count = 0;
 
-          p->vel = Vector2Scale(p->vel, (float)GetRandomValue(600, 900));
+    for(s64 i = 0; i < count; i++) {
+      if(pool->live[i] >= pool->lifetime[i]) continue;
 
-          p->radius = get_random_float(0.3f, 0.7f, 4);
-          p->shrink = (1.1*p->radius)/p->lifetime;
+      if(live_count != i) {
+#define X(type, field) pool->field[live_count] = pool->field[i];
+        PARTICLE_POOL_FIELDS
+#undef X
+      }
 
-          p->friction = (float)GetRandomValue(0, 5);
+      live_count++;
+    }
 
-          p->begin_tint = (Color){ 255, 188, 3, 255 };
-          p->end_tint = ColorAlpha(p->begin_tint, 0.83);
+    pool->count = live_count;
+    gp->live_particles = (u32)live_count;
 
-        }
+  } /* compact */
 
-      } break;
-    case PARTICLE_EMITTER_BLOOD_SPIT:
-      {
-        n_particles = GetRandomValue(50, 60);
-        ASSERT(n_particles <= MAX_PARTICLES);
+}
 
-        for(int i = 0; i < n_particles; i++) {
-          Particle *p = buf + i;
-          *p = (Particle){0};
+void particles_draw(Game *gp) {
+  Particle_pool *pool = &gp->particles;
+  Mesh mesh = gp->particle_mesh;
 
-          p->lifetime = get_random_float(TARGET_FRAME_TIME * 10, TARGET_FRAME_TIME * 20, 10);
+  f32 *vertices = mesh.vertices;
+  u8  *colors = mesh.colors;
+  s64  quads = 0;
 
-          p->pos = ep->pos;
-          p->vel =
-            Vector2Rotate(Vector2Normalize(Vector2Negate(ep->vel)),
-                get_random_float(-PI*0.1f, PI*0.1f, 200));
+  for(s64 i = 0; i < pool->count; i++) {
+    f32 x = pool->pos_x[i];
+    f32 y = pool->pos_y[i];
+    f32 radius = pool->radius[i];
 
-          p->vel = Vector2Scale(p->vel, (float)GetRandomValue(1500, 1800));
+    if(!CheckCollisionCircleRec((Vector2){ x, y }, radius, gp->cam_view_rect)) continue;
 
-          p->radius = get_random_float(1.6f, 2.2f, 4);
-          p->shrink = 12.3f;
+    Color tint = ColorLerp(pool->begin_tint[i], pool->end_tint[i], Normalize(pool->live[i], 0, pool->lifetime[i]));
 
-          p->friction = (float)GetRandomValue(0, 20);
+    f32 x0 = x - radius, x1 = x + radius;
+    f32 y0 = y - radius, y1 = y + radius;
 
-          p->begin_tint = BLOOD;
-          p->end_tint = ColorAlpha(BLOOD, 0.85);
+    /* top left, bottom left, bottom right, top right, same winding as DrawRectangleRec */
+    f32 *v = vertices + quads*12;
+    v[0] = x0; v[1]  = y0; v[2]  = 0;
+    v[3] = x0; v[4]  = y1; v[5]  = 0;
+    v[6] = x1; v[7]  = y1; v[8]  = 0;
+    v[9] = x1; v[10] = y0; v[11] = 0;
 
-        }
+    u8 *c = colors + quads*16;
+    for(int k = 0; k < 4; k++) {
+      c[k*4 + 0] = tint.r;
+      c[k*4 + 1] = tint.g;
+      c[k*4 + 2] = tint.b;
+      c[k*4 + 3] = tint.a;
+    }
 
-      } break;
+    quads++;
   }
 
-  for(int i = 0; i < n_particles; i++) {
-    if(gp->particles_pos >= MAX_PARTICLES) {
-      gp->particles_pos = 0;
-    }
+  if(quads == 0) return;
 
-    gp->particles[gp->particles_pos++] = buf[i];
+  UpdateMeshBuffer(mesh, RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, vertices, (int)(sizeof(f32) * 12 * quads), 0);
+  UpdateMeshBuffer(mesh, RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, colors, (int)(sizeof(u8) * 16 * quads), 0);
 
-  }
+  mesh.triangleCount = (int)(quads*2);
+
+  /* flush everything batched so far so particles still land on top of it */
+  rlDrawRenderBatchActive();
+  DrawMesh(mesh, gp->particle_material, MatrixIdentity());
+}
 
+force_inline void entity_emit_particles(Game *gp, Entity *ep) {
+  emit_particles(gp, ep->particle_emitter, ep->pos, ep->vel);
 }
 
 void entity_shoot_gun(Game *gp, Entity *ep) {
-  Gun *gun = &ep->gun;
+  Gun *gun = &entity_cold(gp, ep)->gun;
 
   if(!gun->cocked) {
 
@@ -2107,6 +2699,10 @@ void entity_shoot_gun(Game *gp, Entity *ep) {
       arm_dir = Vector2Transform(gun->dir, arm_transform);
     }
 
+    b32 use_projectiles =
+      !(gun->bullet_flags & ~PROJECTILE_BULLET_FLAGS) &&
+      !(gun->bullet_sprite.flags & ~SPRITE_FLAG_STILL);
+
     for(int arm_i = 0; arm_i < gun->n_arms; arm_i++) {
 
       Vector2 step_dir = {0};
@@ -2150,12 +2746,56 @@ void entity_shoot_gun(Game *gp, Entity *ep) {
       }
 
       for(int bullet_i = 0; bullet_i < gun->n_bullets; bullet_i++) {
+
+        Vector2 pos;
+
+        if(gun->flags & GUN_FLAG_USE_POINT_BAG) {
+          pos = positions[bullet_i];
+        } else {
+          pos = bullet_pos;
+          bullet_pos = Vector2Add(bullet_pos, step_dir);
+        }
+
+        camera_shake(gp, gun->cam_shake_duration, gun->cam_shake_magnitude);
+
+        if(IsSoundValid(gun->sound)) {
+          SetSoundPan(gun->sound, Normalize(ep->pos.x, WINDOW_WIDTH, 0));
+          SetSoundVolume(gun->sound, 0.2);
+          SetSoundPitch(gun->sound, rng_range_f32(&gp->rng[RNG_STREAM_COSMETIC], 0.98f, 1.01f));
+          PlaySound(gun->sound);
+        }
+
+        if(use_projectiles && gp->projectiles_count < MAX_PROJECTILES) {
+          Projectile *p = &gp->projectiles[gp->projectiles_count++];
+
+          *p =
+            (Projectile){
+              .pos = pos,
+              .prev_pos = pos,
+              .vel = Vector2Scale(arm_dir, gun->bullet_vel),
+              .radius = gun->bullet_radius,
+              .friction = (gun->bullet_flags & ENTITY_FLAG_APPLY_FRICTION) ? gun->bullet_friction : 0,
+              .lifetime = (gun->bullet_flags & ENTITY_FLAG_HAS_LIFETIME) ? gun->bullet_lifetime : 0,
+              .damage = gun->bullet_damage,
+              .collision_mask = gun->bullet_collision_mask,
+              .flags = DEFAULT_BULLET_FLAGS | gun->bullet_flags,
+              .death_particle_emitter = gun->bullet_death_particle_emitter,
+              .sprite_frame = __sprite_frames[gun->bullet_sprite.first_frame],
+              .sprite_scale = gun->bullet_sprite_scale,
+              .sprite_rotation = ep->look_angle * RAD2DEG,
+              .sprite_tint = gun->bullet_sprite_tint,
+              .bounds_color = gun->bullet_bounds_color,
+            };
+
+          continue;
+        }
+
         Entity *bullet = entity_spawn(gp);
 
 
         bullet->kind = gun->bullet_kind;
-        bullet->update_order = ENTITY_ORDER_FIRST;
-        bullet->draw_order = ENTITY_ORDER_LAST;
+        entity_set_update_order(gp, bullet, ENTITY_ORDER_FIRST);
+        entity_set_draw_order(gp, bullet, ENTITY_ORDER_LAST);
 
         bullet->flags = DEFAULT_BULLET_FLAGS | gun->bullet_flags;
 
@@ -2172,21 +2812,12 @@ void entity_shoot_gun(Game *gp, Entity *ep) {
         bullet->scalar_vel = gun->bullet_vel;
         bullet->vel = Vector2Scale(arm_dir, gun->bullet_vel);
 
-        camera_shake(gp, gun->cam_shake_duration, gun->cam_shake_magnitude);
-
-        if(IsSoundValid(gun->sound)) {
-          SetSoundPan(gun->sound, Normalize(ep->pos.x, WINDOW_WIDTH, 0));
-          SetSoundVolume(gun->sound, 0.2);
-          SetSoundPitch(gun->sound, get_random_float(0.98, 1.01, 4));
-          PlaySound(gun->sound);
-        }
-
         bullet->friction = gun->bullet_friction;
         //bullet->vel = Vector2Add(bullet->vel, Vector2Scale(gun->dir, Vector2DotProduct(gun->dir, ep->vel)));
 
         bullet->radius = gun->bullet_radius;
 
-        bullet->apply_collision_mask = ep->gun.bullet_collision_mask;
+        bullet->apply_collision_mask = gun->bullet_collision_mask;
         bullet->damage_amount = gun->bullet_damage;
 
         bullet->spawn_particle_emitter = gun->bullet_spawn_particle_emitter;
@@ -2196,12 +2827,7 @@ void entity_shoot_gun(Game *gp, Entity *ep) {
           bullet->life_time_duration = gun->bullet_lifetime;
         }
 
-        if(gun->flags & GUN_FLAG_USE_POINT_BAG) {
-          bullet->pos = positions[bullet_i];
-        } else {
-          bullet->pos = bullet_pos;
-          bullet_pos = Vector2Add(bullet_pos, step_dir);
-        }
+        bullet->pos = pos;
 
       } /* bullet loop */
 
@@ -2217,6 +2843,8 @@ shoot_end:;
 force_inline b32 entity_check_collision(Game *gp, Entity *a, Entity *b) {
   b32 result = 0;
 
+  gp->collision_counts[COLLISION_COUNTER_ENTITY_TESTS]++;
+
   float sqr_min_dist = SQUARE(a->radius + b->radius);
 
   if(Vector2DistanceSqr(a->pos, b->pos) < sqr_min_dist) {
@@ -2226,89 +2854,419 @@ force_inline b32 entity_check_collision(Game *gp, Entity *a, Entity *b) {
   return result;
 }
 
-void sprite_update(Game *gp, Entity *ep) {
-  ep->sprite_rotation = ep->look_angle * RAD2DEG;
-
-  Sprite *sp = &ep->sprite;
-  if(!(sp->flags & SPRITE_FLAG_STILL)) {
+/*
+ * Sweeps a point from p0 to p1 against a circle and returns the fraction of
+ * the sweep at which it first touches it. Circle vs circle reduces to this by
+ * summing the radii and sweeping one center relative to the other.
+ */
+force_inline b32 circle_sweep_time_of_impact(Vector2 p0, Vector2 p1, Vector2 center, float radius, float *toi) {
+  b32 result = 0;
 
-    ASSERT(sp->fps > 0);
+  Vector2 d = Vector2Subtract(p1, p0);
+  Vector2 m = Vector2Subtract(p0, center);
 
-    if(sp->cur_frame < sp->total_frames) {
-      sp->frame_counter++;
+  float a = Vector2DotProduct(d, d);
+  float b = Vector2DotProduct(m, d);
+  float c = Vector2DotProduct(m, m) - SQUARE(radius);
 
-      if(sp->frame_counter >= (TARGET_FPS / sp->fps)) {
-        sp->frame_counter = 0;
-        sp->cur_frame++;
-      }
+  if(c < 0) {
+    *toi = 0;
+    result = 1;
+  } else if(b < 0 && a > 0) {
+    float disc = b*b - a*c;
 
-    }
+    if(disc >= 0) {
+      float t = (-b - sqrtf(disc)) / a;
 
-    if(sp->cur_frame >= sp->total_frames) {
-      if(sp->flags & SPRITE_FLAG_INFINITE_REPEAT) {
-        if(sp->flags & SPRITE_FLAG_PINGPONG) {
-          sp->cur_frame--;
-          sp->flags ^= SPRITE_FLAG_REVERSE;
-        } else {
-          sp->cur_frame = 0;
-        }
-      } else {
-        sp->cur_frame--;
-        sp->flags |= SPRITE_FLAG_AT_LAST_FRAME | SPRITE_FLAG_STILL;
-        ASSERT(sp->cur_frame >= 0 && sp->cur_frame < sp->total_frames);
+      if(t <= 1.0f) {
+        *toi = t;
+        result = 1;
       }
+
     }
 
   }
 
+  return result;
 }
 
-Sprite_frame sprite_current_frame(Sprite sp) {
-  s32 abs_cur_frame = sp.first_frame + sp.cur_frame;
-
-  if(sp.flags & SPRITE_FLAG_REVERSE) {
-    abs_cur_frame = sp.last_frame - sp.cur_frame;
-  }
-
-  Sprite_frame frame = __sprite_frames[abs_cur_frame];
-
-  return frame;
+/*
+ * Swept version of entity_check_collision, a moves from prev_pos to pos and b is
+ * taken where it stands, since it either hasn't moved yet this frame or already has.
+ */
+force_inline b32 entity_check_swept_collision(Game *gp, Entity *a, Entity *b, float *toi) {
+  gp->collision_counts[COLLISION_COUNTER_ENTITY_TESTS]++;
+  return circle_sweep_time_of_impact(a->prev_pos, a->pos, b->pos, a->radius + b->radius, toi);
 }
 
-b32 sprite_at_keyframe(Sprite sp, s32 keyframe) {
-  b32 result = 0;
+force_inline u32 spatial_grid_bucket(s32 cell_x, s32 cell_y) {
+  u32 h = ((u32)cell_x * 73856093u) ^ ((u32)cell_y * 19349663u);
+  return h & (SPATIAL_GRID_BUCKETS - 1);
+}
 
-  s32 abs_cur_frame = sp.first_frame + sp.cur_frame;
+force_inline void spatial_grid_cell_range(Vector2 pos, float extent, s32 *x0, s32 *y0, s32 *x1, s32 *y1) {
+  *x0 = (s32)floorf((pos.x - extent) * INV_SPATIAL_GRID_CELL_SIZE);
+  *y0 = (s32)floorf((pos.y - extent) * INV_SPATIAL_GRID_CELL_SIZE);
+  *x1 = (s32)floorf((pos.x + extent) * INV_SPATIAL_GRID_CELL_SIZE);
+  *y1 = (s32)floorf((pos.y + extent) * INV_SPATIAL_GRID_CELL_SIZE);
+}
 
-  if(sp.flags & SPRITE_FLAG_REVERSE) {
-    abs_cur_frame = sp.last_frame - sp.cur_frame;
-  }
+force_inline float spatial_grid_entity_extent(Game *gp, Entity *ep) {
+  /* pad by this frame's motion so the entity stays findable after it moves */
+  float extent = ep->radius + Vector2Length(ep->vel) * gp->dt;
 
-  if(abs_cur_frame == keyframe) {
-    result = 1;
+  if(ep->flags & ENTITY_FLAG_IS_INTERACTABLE) {
+    extent = MAX(extent, ep->interact_radius);
   }
 
-  return result;
+  return extent;
 }
 
-b32 sprite_equals(Sprite a, Sprite b) {
-  return !!(a.id == b.id);
-}
+void spatial_grid_build(Game *gp) {
+  Spatial_grid *grid = &gp->grid;
 
-void draw_sprite(Game *gp, Entity *ep) {
-  Sprite sp = ep->sprite;
-  Vector2 pos = Vector2Add(ep->pos, ep->sprite_offset);
-  f32 scale = ep->sprite_scale;
-  f32 rotation = ep->sprite_rotation;
-  Color tint = ep->sprite_tint;
+  u32 *bucket_start = grid->bucket_start;
+  memory_zero(bucket_start, sizeof(u32) * (SPATIAL_GRID_BUCKETS + 1));
 
-  if(ep->flags & ENTITY_FLAG_APPLY_EFFECT_TINT) {
-    tint = ColorLerp(ep->sprite_tint, ep->effect_tint, Normalize(ep->effect_tint_timer, 0, ep->effect_tint_duration));
+  s64 live_count = 0;
+  for(Entity_order order = ENTITY_ORDER_FIRST; order < ENTITY_ORDER_MAX; order++) {
+    live_count += gp->update_lists[order].count;
   }
 
-  ASSERT(sp.cur_frame >= 0 && sp.cur_frame < sp.total_frames);
+  grid->large_entities = frame_push_array_no_zero(u16, live_count + 1);
+  grid->large_entities_count = 0;
 
-  Sprite_frame frame;
+  { /* count */
+
+    for(Entity_order order = ENTITY_ORDER_FIRST; order < ENTITY_ORDER_MAX; order++)
+    for(s64 i = 0; i < gp->update_lists[order].count; i++) {
+      Entity *ep = gp->update_lists[order].d[i];
+
+      s32 x0, y0, x1, y1;
+      spatial_grid_cell_range(ep->pos, spatial_grid_entity_extent(gp, ep), &x0, &y0, &x1, &y1);
+
+      if((s64)(x1 - x0 + 1) * (s64)(y1 - y0 + 1) > SPATIAL_GRID_MAX_CELLS_PER_ENTITY) {
+        grid->large_entities[grid->large_entities_count++] = entity_slot(gp, ep);
+        continue;
+      }
+
+      for(s32 y = y0; y <= y1; y++) {
+        for(s32 x = x0; x <= x1; x++) {
+          bucket_start[spatial_grid_bucket(x, y)]++;
+        }
+      }
+
+    }
+
+  } /* count */
+
+  u32 total = 0;
+  for(int b = 0; b < SPATIAL_GRID_BUCKETS; b++) {
+    total += bucket_start[b];
+    bucket_start[b] = total;
+  }
+  bucket_start[SPATIAL_GRID_BUCKETS] = total;
+
+  grid->bucket_entities = frame_push_array_no_zero(u16, total + 1);
+  grid->bucket_entities_count = total;
+
+  { /* fill */
+
+    /* bucket_start holds the end of each bucket, filling backwards leaves it at the start */
+    for(Entity_order order = ENTITY_ORDER_FIRST; order < ENTITY_ORDER_MAX; order++)
+    for(s64 i = 0; i < gp->update_lists[order].count; i++) {
+      Entity *ep = gp->update_lists[order].d[i];
+
+      s32 x0, y0, x1, y1;
+      spatial_grid_cell_range(ep->pos, spatial_grid_entity_extent(gp, ep), &x0, &y0, &x1, &y1);
+
+      if((s64)(x1 - x0 + 1) * (s64)(y1 - y0 + 1) > SPATIAL_GRID_MAX_CELLS_PER_ENTITY) {
+        continue;
+      }
+
+      u16 slot = entity_slot(gp, ep);
+
+      for(s32 y = y0; y <= y1; y++) {
+        for(s32 x = x0; x <= x1; x++) {
+          u32 b = spatial_grid_bucket(x, y);
+          grid->bucket_entities[--bucket_start[b]] = slot;
+        }
+      }
+
+    }
+
+  } /* fill */
+
+}
+
+Slice(Entity_ptr) spatial_grid_query(Game *gp, Vector2 pos, float radius) {
+  Spatial_grid *grid = &gp->grid;
+  Slice(Entity_ptr) result = {0};
+
+  grid->query_index++;
+  if(grid->query_index == 0) {
+    memory_zero(grid->query_stamp, sizeof(u32) * MAX_ENTITIES);
+    grid->query_index = 1;
+  }
+
+  s32 x0, y0, x1, y1;
+  spatial_grid_cell_range(pos, radius, &x0, &y0, &x1, &y1);
+
+  u32 cap = grid->large_entities_count;
+
+  for(s32 y = y0; y <= y1; y++) {
+    for(s32 x = x0; x <= x1; x++) {
+      u32 b = spatial_grid_bucket(x, y);
+      cap += grid->bucket_start[b + 1] - grid->bucket_start[b];
+    }
+  }
+
+  gp->collision_counts[COLLISION_COUNTER_GRID_QUERIES]++;
+
+  if(cap == 0) {
+    return result;
+  }
+
+  result.d = frame_push_array_no_zero(Entity_ptr, cap);
+
+  for(s32 y = y0; y <= y1; y++) {
+    for(s32 x = x0; x <= x1; x++) {
+      u32 b = spatial_grid_bucket(x, y);
+
+      for(u32 k = grid->bucket_start[b]; k < grid->bucket_start[b + 1]; k++) {
+        u16 index = grid->bucket_entities[k];
+
+        if(grid->query_stamp[index] != grid->query_index) {
+          grid->query_stamp[index] = grid->query_index;
+
+          Entity *ep = &gp->entities[index];
+          if(ep->live) {
+            result.d[result.count++] = ep;
+          }
+        }
+
+      }
+
+    }
+  }
+
+  for(u32 k = 0; k < grid->large_entities_count; k++) {
+    Entity *ep = &gp->entities[grid->large_entities[k]];
+    if(ep->live) {
+      result.d[result.count++] = ep;
+    }
+  }
+
+  gp->collision_counts[COLLISION_COUNTER_CANDIDATES] += (u32)result.count;
+
+  return result;
+}
+
+void projectiles_update(Game *gp) {
+  Projectile *projectiles = gp->projectiles;
+  s64 count = gp->projectiles_count;
+  f32 dt = gp->dt;
+
+  { /* integrate */
+
+    for(s64 i = 0; i < count; i++) {
+      Projectile *p = projectiles + i;
+
+      p->prev_pos = p->pos;
+      p->vel = Vector2Subtract(p->vel, Vector2Scale(p->vel, p->friction*dt));
+      p->pos = Vector2Add(p->pos, Vector2Scale(p->vel, dt));
+
+      p->dead = (p->lifetime > 0) & (p->life_timer >= p->lifetime);
+      p->life_timer += dt;
+    }
+
+  } /* integrate */
+
+  { /* tile test */
+
+    u8 *tiles = gp->tiles;
+
+    for(s64 i = 0; i < count; i++) {
+      Projectile *p = projectiles + i;
+      p->dead |= !!((1ull<<tiles[tile_from_point(p->pos)]) & COLLIDABLE_TILE_MASK);
+    }
+
+  } /* tile test */
+
+  { /* hit test */
+
+    for(s64 i = 0; i < count; i++) {
+      Projectile *p = projectiles + i;
+
+      /* query the whole swept segment so fast rounds can't skip over anything */
+      Vector2 sweep_center = Vector2Lerp(p->prev_pos, p->pos, 0.5f);
+      float sweep_radius = 0.5f*Vector2Distance(p->prev_pos, p->pos) + p->radius;
+
+      Slice(Entity_ptr) candidates = spatial_grid_query(gp, sweep_center, sweep_radius);
+
+      Entity *hit = 0;
+      float hit_toi = 2.0f;
+
+      for(s64 j = 0; j < candidates.count; j++) {
+        Entity *colliding = candidates.d[j];
+
+        if(!entity_kind_in_mask(colliding->kind, p->collision_mask)) continue;
+
+        gp->collision_counts[COLLISION_COUNTER_ENTITY_TESTS]++;
+
+        float toi;
+        if(circle_sweep_time_of_impact(p->prev_pos, p->pos, colliding->pos, p->radius + colliding->radius, &toi)) {
+          if(toi < hit_toi) {
+            hit = colliding;
+            hit_toi = toi;
+          }
+        }
+
+      }
+
+      if(hit) {
+        hit->received_collision = 1;
+        hit->received_damage += p->damage;
+        p->pos = Vector2Lerp(p->prev_pos, p->pos, hit_toi);
+        p->dead = 1;
+      }
+
+    }
+
+  } /* hit test */
+
+  { /* die */
+
+    s64 live_count = 0;
+
+    for(s64 i = 0; i < count; i++) {
+      Projectile *p = projectiles + i;
+
+      if(p->dead) {
+        if(p->flags & ENTITY_FLAG_EMIT_DEATH_PARTICLES) {
+          if(CheckCollisionCircleRec(p->pos, p->radius, gp->sim_view_rect)) {
+            emit_particles(gp, p->death_particle_emitter, p->pos, p->vel);
+          }
+        }
+        continue;
+      }
+
+      projectiles[live_count++] = *p;
+    }
+
+    gp->projectiles_count = live_count;
+
+  } /* die */
+
+}
+
+void projectiles_draw(Game *gp) {
+
+  for(s64 i = 0; i < gp->projectiles_count; i++) {
+    Projectile *p = gp->projectiles + i;
+
+    Sprite_frame frame = p->sprite_frame;
+    float draw_radius = MAX(p->radius, 0.5f*p->sprite_scale*sqrtf((float)(frame.w*frame.w + frame.h*frame.h)));
+
+    Vector2 pos = Vector2Lerp(p->prev_pos, p->pos, gp->sim_alpha);
+
+    if(!CheckCollisionCircleRec(pos, draw_radius, gp->cam_view_rect)) continue;
+
+    if(p->flags & ENTITY_FLAG_HAS_SPRITE) {
+      draw_sprite_frame(gp, p->sprite_frame, 0, pos, p->sprite_scale, p->sprite_rotation, p->sprite_tint);
+    }
+
+    if(gp->debug_flags & GAME_DEBUG_FLAG_DRAW_ALL_ENTITY_BOUNDS) {
+      DrawCircleLinesV(pos, p->radius, p->bounds_color);
+    }
+
+  }
+
+}
+
+void sprite_update(Game *gp, Entity *ep) {
+  ep->sprite_rotation = ep->look_angle * RAD2DEG;
+
+  Sprite *sp = &ep->sprite;
+  if(!(sp->flags & SPRITE_FLAG_STILL)) {
+
+    ASSERT(sp->fps > 0);
+
+    if(sp->cur_frame < sp->total_frames) {
+      sp->frame_counter++;
+
+      if(sp->frame_counter >= (TARGET_FPS / sp->fps)) {
+        sp->frame_counter = 0;
+        sp->cur_frame++;
+      }
+
+    }
+
+    if(sp->cur_frame >= sp->total_frames) {
+      if(sp->flags & SPRITE_FLAG_INFINITE_REPEAT) {
+        if(sp->flags & SPRITE_FLAG_PINGPONG) {
+          sp->cur_frame--;
+          sp->flags ^= SPRITE_FLAG_REVERSE;
+        } else {
+          sp->cur_frame = 0;
+        }
+      } else {
+        sp->cur_frame--;
+        sp->flags |= SPRITE_FLAG_AT_LAST_FRAME | SPRITE_FLAG_STILL;
+        ASSERT(sp->cur_frame >= 0 && sp->cur_frame < sp->total_frames);
+      }
+    }
+
+  }
+
+}
+
+Sprite_frame sprite_current_frame(Sprite sp) {
+  s32 abs_cur_frame = sp.first_frame + sp.cur_frame;
+
+  if(sp.flags & SPRITE_FLAG_REVERSE) {
+    abs_cur_frame = sp.last_frame - sp.cur_frame;
+  }
+
+  Sprite_frame frame = __sprite_frames[abs_cur_frame];
+
+  return frame;
+}
+
+b32 sprite_at_keyframe(Sprite sp, s32 keyframe) {
+  b32 result = 0;
+
+  s32 abs_cur_frame = sp.first_frame + sp.cur_frame;
+
+  if(sp.flags & SPRITE_FLAG_REVERSE) {
+    abs_cur_frame = sp.last_frame - sp.cur_frame;
+  }
+
+  if(abs_cur_frame == keyframe) {
+    result = 1;
+  }
+
+  return result;
+}
+
+b32 sprite_equals(Sprite a, Sprite b) {
+  return !!(a.id == b.id);
+}
+
+void draw_sprite(Game *gp, Entity *ep) {
+  Sprite sp = ep->sprite;
+  Vector2 pos = Vector2Add(ep->pos, ep->sprite_offset);
+  f32 scale = ep->sprite_scale;
+  f32 rotation = ep->sprite_rotation;
+  Color tint = ep->sprite_tint;
+
+  if(ep->flags & ENTITY_FLAG_APPLY_EFFECT_TINT) {
+    tint = ColorLerp(ep->sprite_tint, ep->effect_tint, Normalize(ep->effect_tint_timer, 0, ep->effect_tint_duration));
+  }
+
+  ASSERT(sp.cur_frame >= 0 && sp.cur_frame < sp.total_frames);
+
+  Sprite_frame frame;
 
   if(sp.flags & SPRITE_FLAG_REVERSE) {
     frame = __sprite_frames[sp.last_frame - sp.cur_frame];
@@ -2316,6 +3274,14 @@ void draw_sprite(Game *gp, Entity *ep) {
     frame = __sprite_frames[sp.first_frame + sp.cur_frame];
   }
 
+  if(ep->flags & ENTITY_FLAG_MANUAL_SPRITE_ORIGIN) {
+  }
+
+  draw_sprite_frame(gp, frame, sp.flags, pos, scale, rotation, tint);
+}
+
+void draw_sprite_frame(Game *gp, Sprite_frame frame, Sprite_flags flags, Vector2 pos, f32 scale, f32 rotation, Color tint) {
+
   Rectangle source_rec =
   {
     .x = (float)frame.x,
@@ -2335,26 +3301,24 @@ void draw_sprite(Game *gp, Entity *ep) {
     .height = scale*source_rec.height,
   };
 
-  if(sp.flags & SPRITE_FLAG_DRAW_MIRRORED_X) {
+  if(flags & SPRITE_FLAG_DRAW_MIRRORED_X) {
     source_rec.width *= -1;
   }
 
-  if(sp.flags & SPRITE_FLAG_DRAW_MIRRORED_Y) {
+  if(flags & SPRITE_FLAG_DRAW_MIRRORED_Y) {
     source_rec.height *= -1;
   }
 
   Vector2 origin = { dest_rec.width*0.5f, dest_rec.height*0.5f };
 
-  if(ep->flags & ENTITY_FLAG_MANUAL_SPRITE_ORIGIN) {
-  }
-
   //DrawRectanglePro(dest_rec, origin, rotation, SKYBLUE);
   DrawTexturePro(gp->sprite_atlas, source_rec, dest_rec, origin, rotation, tint);
 }
 
 Game* game_init(void) {
 
-  SetRandomSeed(42);
+  SetRandomSeed(RNG_SEED);
+#ifndef HEADLESS
   SetConfigFlags(FLAG_WINDOW_RESIZABLE);
   InitWindow(1000, 800, GAME_TITLE);
   InitAudioDevice();
@@ -2363,6 +3327,7 @@ Game* game_init(void) {
   //SetMasterVolume(GetMasterVolume() * 0.5);
 
   SetTargetFPS(TARGET_FPS);
+#endif
   SetTextLineSpacing(10);
   SetTraceLogLevel(LOG_DEBUG);
   SetExitKey(0);
@@ -2370,12 +3335,48 @@ Game* game_init(void) {
   Game *gp = os_alloc(sizeof(Game));
   memory_set(gp, 0, sizeof(Game));
 
-  gp->main_arena  = arena_alloc(.size = MB(3));
-  gp->level_arena = arena_alloc(.size = KB(16));
-  gp->frame_arena = arena_alloc(.size = KB(8));
+  rng_seed(&gp->rng[RNG_STREAM_PARTICLES], RNG_SEED, RNG_STREAM_PARTICLES);
+  rng_seed(&gp->rng[RNG_STREAM_COSMETIC],  RNG_SEED, RNG_STREAM_COSMETIC);
+
+  /* reserved so heavy frames and long recordings grow in place instead of chaining */
+  gp->main_arena  = arena_alloc(.size = MB(3),  .reserve_size = GB(1));
+  gp->level_arena = arena_alloc(.size = KB(16), .reserve_size = GB(1));
+  gp->frame_arena = arena_alloc(.size = KB(8),  .reserve_size = GB(1));
+  gp->replay.arena = arena_alloc(.size = KB(64), .reserve_size = GB(1));
+
+  context_init();
+
+  /* registered here and not in context_init, the registry isn't thread safe and workers init their own */
+  for(s32 i = 0; i < CONTEXT_SCRATCH_COUNT; i++) {
+    arena_register(context_scratch_arenas[i], (char*)push_str8f(gp->main_arena, "scratch %i", i).s);
+  }
+  arena_register(gp->main_arena,   "main");
+  arena_register(gp->level_arena,  "level");
+  arena_register(gp->frame_arena,  "frame");
+  arena_register(gp->replay.arena, "replay");
+
+  pool_init(&gp->entity_node_pool, gp->level_arena, Entity_node);
+  pool_init(&gp->waypoint_pool, gp->level_arena, Waypoint);
+
+  gp->mu = os_alloc(sizeof(mu_Context));
+  mu_init(gp->mu);
 
   gp->entities  = push_array_no_zero(gp->main_arena, Entity, MAX_ENTITIES);
-  gp->particles = push_array_no_zero(gp->main_arena, Particle, MAX_PARTICLES);
+  gp->entity_cold = push_array_no_zero(gp->main_arena, Entity_cold, MAX_ENTITIES);
+  gp->entity_generation = push_array(gp->main_arena, u16, MAX_ENTITIES);
+  gp->entity_uid_table  = push_array(gp->main_arena, u16, ENTITY_UID_TABLE_SIZE);
+
+  for(Entity_order order = ENTITY_ORDER_FIRST; order < ENTITY_ORDER_MAX; order++) {
+    gp->update_lists[order].d = push_array_no_zero(gp->main_arena, Entity_ptr, MAX_ENTITIES);
+    gp->draw_lists[order].d   = push_array_no_zero(gp->main_arena, Entity_ptr, MAX_ENTITIES);
+  }
+#define X(type, field) gp->particles.field = push_array_no_zero_aligned(gp->main_arena, type, MAX_PARTICLES, 16);
+  PARTICLE_POOL_FIELDS
+#undef X
+  gp->projectiles = push_array_no_zero(gp->main_arena, Projectile, MAX_PROJECTILES);
+
+  gp->grid.bucket_start = push_array(gp->main_arena, u32, SPATIAL_GRID_BUCKETS + 1);
+  gp->grid.query_stamp  = push_array(gp->main_arena, u32, MAX_ENTITIES);
 
   gp->editor.tiles = push_array(gp->main_arena, u8, TILES_COUNT);
   arr_init_ex(gp->editor.static_entities, gp->main_arena, 64);
@@ -2388,6 +3389,8 @@ Game* game_init(void) {
     (Camera2D) {
       .zoom = INITIAL_CAMERA_ZOOM,
     };
+  gp->cam_view_rect = camera_view_rect(gp->cam);
+  gp->sim_view_rect = gp->cam_view_rect;
 
   game_load_assets(gp);
 
@@ -2407,6 +3410,55 @@ void game_load_assets(Game *gp) {
   gp->sprite_atlas = LoadTexture("./aseprite/atlas.png");
   SetTextureFilter(gp->sprite_atlas, TEXTURE_FILTER_POINT);
 
+  { /* tile chunks */
+    Color blank_pixels[TILE_CHUNK_SIZE*TILE_CHUNK_SIZE] = {0};
+
+    Image blank =
+    {
+      .data = blank_pixels,
+      .width = TILE_CHUNK_SIZE,
+      .height = TILE_CHUNK_SIZE,
+      .mipmaps = 1,
+      .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+
+    for(s64 i = 0; i < TILE_CHUNKS_COUNT; i++) {
+      gp->tile_chunk_textures[i] = LoadTextureFromImage(blank);
+      SetTextureFilter(gp->tile_chunk_textures[i], TEXTURE_FILTER_POINT);
+    }
+
+    tile_chunks_mark_all_dirty(gp);
+  } /* tile chunks */
+
+  { /* particle mesh */
+    Mesh mesh = {0};
+
+    mesh.vertexCount   = MAX_PARTICLES*4;
+    mesh.triangleCount = MAX_PARTICLES*2;
+    mesh.vertices  = MemAlloc(sizeof(f32) * 3 * mesh.vertexCount);
+    mesh.texcoords = MemAlloc(sizeof(f32) * 2 * mesh.vertexCount);
+    mesh.colors    = MemAlloc(sizeof(u8) * 4 * mesh.vertexCount);
+    mesh.indices   = MemAlloc(sizeof(u16) * 3 * mesh.triangleCount);
+
+    /* quads never change topology, only the first triangleCount indices get drawn */
+    for(s64 i = 0; i < MAX_PARTICLES; i++) {
+      u16 *quad = mesh.indices + i*6;
+      u16 v = (u16)(i*4);
+
+      quad[0] = v + 0;
+      quad[1] = v + 1;
+      quad[2] = v + 3;
+      quad[3] = v + 3;
+      quad[4] = v + 1;
+      quad[5] = v + 2;
+    }
+
+    UploadMesh(&mesh, true);
+
+    gp->particle_mesh = mesh;
+    gp->particle_material = LoadMaterialDefault();
+  } /* particle mesh */
+
   /* sounds */
 
   /* music */
@@ -2421,6 +3473,13 @@ void game_load_assets(Game *gp) {
 
 void game_unload_assets(Game *gp) {
 
+  UnloadMesh(gp->particle_mesh);
+  UnloadMaterial(gp->particle_material);
+
+  for(s64 i = 0; i < TILE_CHUNKS_COUNT; i++) {
+    UnloadTexture(gp->tile_chunk_textures[i]);
+  }
+
   //UnloadRenderTexture(gp->render_texture);
   //UnloadTexture(gp->sprite_atlas);
   //UnloadTexture(gp->background_texture);
@@ -2442,12 +3501,17 @@ void game_unload_assets(Game *gp) {
 void game_close(Game *gp) {
   game_unload_assets(gp);
 
+  context_close();
+
   CloseWindow();
   CloseAudioDevice();
 }
 
 void game_reset(Game *gp) {
 
+  /* a recording or playback only makes sense from the reset it started at */
+  replay_stop(gp);
+
   gp->state = GAME_STATE_NONE;
   gp->next_state = GAME_STATE_NONE;
 
@@ -2460,17 +3524,31 @@ void game_reset(Game *gp) {
   gp->entities_allocated = 0;
   gp->live_entities = 0;
 
-  gp->particles_pos = 0;
+  gp->particles.count = 0;
   gp->live_particles = 0;
 
+  rng_seed(&gp->rng[RNG_STREAM_GAMEPLAY], RNG_SEED, RNG_STREAM_GAMEPLAY);
+  rng_seed(&gp->rng[RNG_STREAM_AI],       RNG_SEED, RNG_STREAM_AI);
+
+  gp->projectiles_count = 0;
+
   memory_set(gp->entities, 0, sizeof(Entity) * MAX_ENTITIES);
-  memory_set(gp->particles, 0, sizeof(Particle) * MAX_PARTICLES);
+  memory_set(gp->entity_cold, 0, sizeof(Entity_cold) * MAX_ENTITIES);
+  memory_set(gp->entity_uid_table, 0, sizeof(u16) * ENTITY_UID_TABLE_SIZE);
+
+  for(Entity_order order = ENTITY_ORDER_FIRST; order < ENTITY_ORDER_MAX; order++) {
+    gp->update_lists[order].count = 0;
+    gp->draw_lists[order].count = 0;
+  }
 
   gp->frame_index = 0;
+  gp->tick_index = 0;
+  gp->sim_accumulator = 0;
+  gp->sim_alpha = 0;
 
-  arena_clear(gp->main_arena);
+  /* the main arena holds what game_init pushed, it lives as long as the game */
   arena_clear(gp->frame_arena);
-  arena_clear(gp->level_arena);
+  level_arena_clear(gp);
 
   //memory_set(&gp->phase, 0, sizeof(gp->phase));
   gp->phase_index = 0;
@@ -2480,6 +3558,9 @@ void game_reset(Game *gp) {
 
   gp->keys = 0;
 
+  gp->scenario.kind = SCENARIO_NONE;
+  gp->scenario.count = 0;
+
   //SeekMusicStream(gp->music, 0);
 
   gp->gameover_pre_delay = 0;
@@ -2488,8 +3569,15 @@ void game_reset(Game *gp) {
 
 }
 
-void game_level_end(Game *gp) {
+/* the pools hand out level arena memory, they go with it */
+void level_arena_clear(Game *gp) {
   arena_clear(gp->level_arena);
+  pool_clear(&gp->entity_node_pool);
+  pool_clear(&gp->waypoint_pool);
+}
+
+void game_level_end(Game *gp) {
+  level_arena_clear(gp);
   gp->level++;
   gp->next_state = GAME_STATE_START_LEVEL;
   gp->flags |= GAME_FLAG_PLAYER_CANNOT_SHOOT;
@@ -2499,6 +3587,7 @@ void game_editor_save_and_close(Game *gp) {
   Editor *editor = &gp->editor;
 
   memory_copy(gp->tiles, editor->tiles, sizeof(u8) * TILES_COUNT);
+  tile_chunks_mark_all_dirty(gp);
 
   gp->cam.target = gp->player->pos;
   gp->cam.zoom = INITIAL_CAMERA_ZOOM;
@@ -2533,12 +3622,568 @@ void game_editor_save_and_close(Game *gp) {
 void game_editor_open(Game *gp) {
   gp->debug_flags |= EDITOR_GAME_DEBUG_FLAGS_MASK;
 
+  /* editor input isn't recorded */
+  replay_stop(gp);
+
+}
+
+void replay_record_begin(Game *gp) {
+  game_reset(gp);
+
+  gp->replay.header =
+    (Replay_header){
+      .magic = REPLAY_MAGIC,
+      .version = REPLAY_VERSION,
+      .sim_dt = SIM_DT,
+      .screen_width = GetScreenWidth(),
+      .screen_height = GetScreenHeight(),
+    };
+  memory_copy(gp->replay.header.rng, gp->rng, sizeof(gp->rng));
+
+  gp->replay.mode = REPLAY_MODE_RECORD;
+
+  TraceLog(LOG_INFO, "REPLAY: recording");
 }
 
+b32 replay_playback_begin(Game *gp, char *path) {
+  /* a recording in progress is saved first, so playing REPLAY_PATH plays what was just recorded */
+  replay_stop(gp);
+
+  int size = 0;
+  u8 *data = LoadFileData(path, &size);
+
+  if(!data) {
+    TraceLog(LOG_WARNING, "REPLAY: could not load %s", path);
+    return 0;
+  }
+
+  Replay_header header = {0};
+  b32 ok = (u64)size >= sizeof(header);
+
+  if(ok) {
+    memory_copy(&header, data, sizeof(header));
+    ok =
+      header.magic == REPLAY_MAGIC &&
+      header.version == REPLAY_VERSION &&
+      header.sim_dt == SIM_DT &&
+      (u64)size == sizeof(header) + header.ticks_count * sizeof(Replay_tick);
+  }
+
+  if(!ok) {
+    TraceLog(LOG_WARNING, "REPLAY: %s is not a replay this build can play", path);
+    UnloadFileData(data);
+    return 0;
+  }
+
+  game_reset(gp);
+
+  gp->replay.header = header;
+  gp->replay.ticks = push_array_no_zero(gp->replay.arena, Replay_tick, header.ticks_count);
+  memory_copy(gp->replay.ticks, data + sizeof(header), header.ticks_count * sizeof(Replay_tick));
+  gp->replay.tick_index = 0;
+
+  UnloadFileData(data);
+
+  memory_copy(gp->rng, header.rng, sizeof(gp->rng));
+
+  if(header.screen_width != GetScreenWidth() || header.screen_height != GetScreenHeight()) {
+    TraceLog(LOG_WARNING, "REPLAY: recorded at %ix%i, playback can diverge at a different screen size",
+        header.screen_width, header.screen_height);
+  }
+
+  gp->replay.mode = REPLAY_MODE_PLAYBACK;
+
+  TraceLog(LOG_INFO, "REPLAY: playing %s, %u ticks", path, header.ticks_count);
+
+  return 1;
+}
+
+void replay_stop(Game *gp) {
+
+  if(gp->replay.mode == REPLAY_MODE_RECORD) {
+    Replay_header *header = &gp->replay.header;
+
+    u64 size = sizeof(Replay_header) + header->ticks_count * sizeof(Replay_tick);
+    u8 *data = push_array_no_zero(gp->replay.arena, u8, size);
+
+    memory_copy(data, header, sizeof(Replay_header));
+
+    u8 *at = data + sizeof(Replay_header);
+    for(Replay_chunk *chunk = gp->replay.first_chunk; chunk; chunk = chunk->next) {
+      memory_copy(at, chunk->ticks, chunk->count * sizeof(Replay_tick));
+      at += chunk->count * sizeof(Replay_tick);
+    }
+
+    if(SaveFileData(REPLAY_PATH, data, (int)size)) {
+      TraceLog(LOG_INFO, "REPLAY: saved %u ticks to %s", header->ticks_count, REPLAY_PATH);
+    }
+
+  } else if(gp->replay.mode == REPLAY_MODE_PLAYBACK) {
+    TraceLog(LOG_INFO, "REPLAY: playback stopped at tick %li", gp->replay.tick_index);
+  }
+
+  gp->replay.mode = REPLAY_MODE_NONE;
+  gp->replay.header = (Replay_header){0};
+  gp->replay.first_chunk = 0;
+  gp->replay.last_chunk = 0;
+  gp->replay.ticks = 0;
+  gp->replay.tick_index = 0;
+  arena_clear(gp->replay.arena);
+
+}
+
+/* the profiler's last completed frames as Chrome trace JSON, the frame in progress is left out */
+b32 trace_write(Game *gp, char *path) {
+  Arena_scope scratch = scratch_begin(0, 0);
+
+  Str8 trace = prof_chrome_trace(scratch.arena);
+  b32 saved = SaveFileData(path, trace.s, (int)trace.len);
+
+  if(saved) {
+    TraceLog(LOG_INFO, "PROF: wrote trace to %s", path);
+  }
+
+  scratch_end(scratch);
+
+  return saved;
+}
+
+/*
+ * Runs at the start of every sim tick. Recording saves what the tick is about
+ * to read, playback overwrites it with what was saved.
+ */
+void replay_tick_input(Game *gp) {
+  Vector2 center = { WINDOW_WIDTH * 0.5f, WINDOW_HEIGHT * 0.5f };
+
+  if(gp->replay.mode == REPLAY_MODE_RECORD) {
+    Replay_chunk *chunk = gp->replay.last_chunk;
+
+    if(!chunk || chunk->count >= REPLAY_CHUNK_TICKS) {
+      chunk = push_struct_no_zero(gp->replay.arena, Replay_chunk);
+      chunk->next = 0;
+      chunk->count = 0;
+      sll_queue_push(gp->replay.first_chunk, gp->replay.last_chunk, chunk);
+    }
+
+    chunk->ticks[chunk->count++] =
+      (Replay_tick){
+        .mouse_offset = Vector2Subtract(gp->mouse_pos, center),
+        .key_pressed = gp->key_pressed,
+        .input_flags = (u16)gp->input_flags,
+      };
+    gp->replay.header.ticks_count++;
+
+  } else if(gp->replay.mode == REPLAY_MODE_PLAYBACK) {
+
+    if(gp->replay.tick_index >= gp->replay.header.ticks_count) {
+      replay_stop(gp);
+      return;
+    }
+
+    Replay_tick tick = gp->replay.ticks[gp->replay.tick_index++];
+
+    gp->input_flags = tick.input_flags;
+    gp->mouse_pos = Vector2Add(center, tick.mouse_offset);
+    gp->key_pressed = tick.key_pressed;
+    gp->character_pressed = (char)tick.key_pressed;
+
+  }
+
+}
+
+#ifdef DEBUG
+Vector2 scenario_random_point(Game *gp) {
+  Rng *rng = &gp->rng[RNG_STREAM_GAMEPLAY];
+
+  float min = (float)TILE_SIZE * (SCENARIO_ROOM_FIRST_TILE + 1);
+  float max = (float)TILE_SIZE * (SCENARIO_ROOM_FIRST_TILE + SCENARIO_ROOM_TILES - 1);
+
+  Vector2 p;
+  do {
+    p.x = rng_range_f32(rng, min, max);
+    p.y = rng_range_f32(rng, min, max);
+  } while(gp->tiles[tile_from_point(p)] != TILE_KIND_FLOOR);
+
+  return p;
+}
+
+/* top tile of door i, doors are laid out in a grid across the room */
+s64 scenario_door_tile(Game *gp, s32 door) {
+  s32 side = (s32)ceilf(sqrtf((float)gp->scenario.count));
+
+  s64 col = SCENARIO_ROOM_FIRST_TILE + 4 + (door % side) * SCENARIO_DOOR_SPACING;
+  s64 row = SCENARIO_ROOM_FIRST_TILE + 4 + (door / side) * SCENARIO_DOOR_SPACING;
+
+  return col + row * TILE_COLS;
+}
+
+void scenario_door_build(Game *gp, s32 door) {
+  Editor *editor = &gp->editor;
+
+  s64 tile = scenario_door_tile(gp, door);
+
+  for(int i = 0; i < SCENARIO_DOOR_TILES; i++) {
+    tile_set(gp, gp->tiles, tile + i * TILE_COLS, TILE_KIND_RED_DOOR);
+    arr_push(editor->selected_door_tiles, tile + i * TILE_COLS);
+  }
+
+  gp->door_color = DOOR_COLOR_RED;
+  spawn_door(gp);
+}
+
+void scenario_begin(Game *gp, Scenario scenario, s32 count) {
+  ASSERT(scenario > SCENARIO_NONE && scenario < SCENARIO_MAX);
+
+  game_reset(gp);
+
+  if(count <= 0) {
+    count = Scenario_default_counts[scenario];
+  }
+
+  switch(scenario) {
+    default:
+      break;
+    case SCENARIO_RAPTOR_CHASE:
+      count = MIN(count, MAX_ENTITIES - 1);
+      break;
+    case SCENARIO_BULLET_CROSSFIRE:
+      count = MIN(count, MAX_PROJECTILES);
+      break;
+    case SCENARIO_DOORS_UNDER_LOAD:
+      count = MIN(count, SQUARE(SCENARIO_MAX_DOORS_PER_SIDE));
+      break;
+  }
+
+  gp->scenario.kind = scenario;
+  gp->scenario.count = count;
+
+  gp->state = GAME_STATE_DEBUG_SANDBOX;
+  gp->next_state = GAME_STATE_DEBUG_SANDBOX;
+
+  /* raptors follow the player, it has to outlive the scenario */
+  gp->debug_flags |= GAME_DEBUG_FLAG_PLAYER_INVINCIBLE;
+
+  { /* walled room */
+    memory_zero(gp->tiles, sizeof(u8) * TILES_COUNT);
+    tile_chunks_mark_all_dirty(gp);
+
+    s64 first = SCENARIO_ROOM_FIRST_TILE;
+    s64 last = SCENARIO_ROOM_FIRST_TILE + SCENARIO_ROOM_TILES - 1;
+
+    for(s64 row = first; row <= last; row++) {
+      for(s64 col = first; col <= last; col++) {
+        b32 wall = row == first || row == last || col == first || col == last;
+        tile_set(gp, gp->tiles, col + row * TILE_COLS, wall ? TILE_KIND_WALL : TILE_KIND_FLOOR);
+      }
+    }
+  } /* walled room */
+
+  Entity *player = spawn_player(gp);
+  gp->player = player;
+  gp->player_handle = handle_from_entity(gp, player);
+
+  gp->flags |=
+    GAME_FLAG_DRAW_IN_CAMERA |
+    0;
+
+  switch(scenario) {
+    default:
+      UNREACHABLE;
+    case SCENARIO_RAPTOR_CHASE:
+      for(s32 i = 0; i < count; i++) {
+        Entity *ep = spawn_raptor(gp);
+        ep->pos = scenario_random_point(gp);
+      }
+      break;
+    case SCENARIO_BULLET_CROSSFIRE:
+      /* something for the bullets to hit that never dies and changes the load */
+      for(s32 i = 0; i < SCENARIO_CROSSFIRE_TARGETS; i++) {
+        Entity *ep = spawn_raptor(gp);
+        ep->pos = scenario_random_point(gp);
+        ep->flags &= ~ENTITY_FLAG_RECEIVE_COLLISION_DAMAGE;
+      }
+      break;
+    case SCENARIO_PARTICLE_BURSTS:
+      break;
+    case SCENARIO_DOORS_UNDER_LOAD:
+      gp->keys = KEY_COLOR_MASK_RED | KEY_COLOR_MASK_BLUE | KEY_COLOR_MASK_YELLOW;
+
+      for(s32 i = 0; i < count; i++) {
+        scenario_door_build(gp, i);
+      }
+
+      for(s32 i = 0; i < SCENARIO_DOORS_RAPTORS; i++) {
+        Entity *ep = spawn_raptor(gp);
+        ep->pos = scenario_random_point(gp);
+      }
+      break;
+  }
+
+}
+
+/* runs from the sandbox state, before the entities update */
+void scenario_tick(Game *gp) {
+  Rng *rng = &gp->rng[RNG_STREAM_GAMEPLAY];
+
+  switch(gp->scenario.kind) {
+    default:
+      UNREACHABLE;
+    case SCENARIO_NONE:
+      break;
+    case SCENARIO_RAPTOR_CHASE:
+      break;
+    case SCENARIO_BULLET_CROSSFIRE:
+      while(gp->projectiles_count < gp->scenario.count) {
+        Projectile *p = &gp->projectiles[gp->projectiles_count++];
+
+        Vector2 pos = scenario_random_point(gp);
+        float angle = rng_range_f32(rng, 0, 2*PI);
+
+        *p =
+          (Projectile){
+            .pos = pos,
+            .prev_pos = pos,
+            .vel = Vector2Scale((Vector2){ cosf(angle), sinf(angle) }, SCENARIO_BULLET_VEL),
+            .radius = 2,
+            .damage = 1,
+            .collision_mask = PLAYER_BULLET_APPLY_COLLISION_MASK,
+            .flags = DEFAULT_BULLET_FLAGS | ENTITY_FLAG_EMIT_DEATH_PARTICLES,
+            .death_particle_emitter = PARTICLE_EMITTER_SPARKS,
+            .sprite_scale = 1.0f,
+            .sprite_rotation = angle * RAD2DEG,
+            .sprite_tint = WHITE,
+            .bounds_color = YELLOW,
+          };
+      }
+      break;
+    case SCENARIO_PARTICLE_BURSTS:
+      {
+        /* particles out of view die before they move, burst where the camera is looking */
+        Rectangle view = gp->sim_view_rect;
+
+        for(s32 i = 0; i < gp->scenario.count; i++) {
+          Particle_emitter emitter = (i & 1) ? PARTICLE_EMITTER_BIG_PLANE_EXPLOSION : PARTICLE_EMITTER_MASSIVE_BLOOD_PUFF;
+          Vector2 pos =
+          {
+            .x = rng_range_f32(rng, view.x, view.x + view.width),
+            .y = rng_range_f32(rng, view.y, view.y + view.height),
+          };
+          emit_particles(gp, emitter, pos, (Vector2){0});
+        }
+      } break;
+    case SCENARIO_DOORS_UNDER_LOAD:
+      {
+        /* walk the doors one per tick, opening the closed ones and rebuilding the open ones */
+        s32 door = (s32)(gp->tick_index % (u64)gp->scenario.count);
+        s64 tile = scenario_door_tile(gp, door);
+
+        if(gp->tiles[tile] == TILE_KIND_FLOOR) {
+          scenario_door_build(gp, door);
+        } else {
+          Entity *player = gp->player;
+          player->pos = Vector2AddValue(point_from_tile(tile + TILE_COLS - 1), (float)TILE_SIZE*0.5f);
+          player->vel = (Vector2){0};
+          gp->input_flags |= INPUT_FLAG_INTERACT;
+        }
+      } break;
+  }
+
+}
+
+#define DEBUG_WINDOW_WIDTH 380
+#define DEBUG_WINDOW_HEIGHT 640
+#define DEBUG_WINDOW_GRAPH_HEIGHT 64
+
+void debug_window_labelf(mu_Context *ctx, char *fmt, ...) {
+  char buf[256];
+
+  va_list args;
+  va_start(args, fmt);
+  stbsp_vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+
+  /* mu_label copies the text into the command list */
+  mu_label(ctx, buf);
+}
+
+void debug_window_bar(mu_Context *ctx, f32 fill) {
+  mu_Rect rect = mu_layout_next(ctx);
+  mu_draw_rect(ctx, rect, ctx->style->colors[MU_COLOR_BASE]);
+
+  rect.w = (int)((f32)rect.w * Clamp(fill, 0.0f, 1.0f));
+  mu_draw_rect(ctx, rect, ctx->style->colors[MU_COLOR_BUTTONHOVER]);
+}
+
+void debug_window_usage(mu_Context *ctx, char *name, u64 used, u64 cap, char *unit) {
+  debug_window_labelf(ctx, "%s", name);
+  debug_window_labelf(ctx, "%llu/%llu%s", (unsigned long long)used, (unsigned long long)cap, unit);
+  debug_window_bar(ctx, cap ? (f32)used / (f32)cap : 0);
+}
+
+/* F11 toggles it, drawn in screen space over everything else */
+void debug_window(Game *gp) {
+  mu_Context *ctx = gp->mu;
+
+  /* set every frame, the font pointer and callbacks don't survive a hot reload */
+  murl_setup_font_ex(ctx, &gp->font);
+
+  /* no keyboard or text input, the game owns the keyboard */
+  murl_handle_mouse_move(ctx);
+  murl_handle_mouse_scroll(ctx);
+  murl_handle_mouse_buttons_input(ctx);
+
+  mu_begin(ctx);
+
+  if(mu_begin_window_ex(ctx, "debug", mu_rect(10, 10, DEBUG_WINDOW_WIDTH, DEBUG_WINDOW_HEIGHT), MU_OPT_NOCLOSE)) {
+
+    if(mu_header_ex(ctx, "frame", MU_OPT_EXPANDED)) { /* frame */
+      Prof_frame *last = prof_last_frame();
+      f64 last_ms = last ? (f64)(last->end_ns - last->begin_ns) * 1e-6 : 0;
+      f64 target_ms = 1000.0 * TARGET_FRAME_TIME;
+
+      mu_layout_row(ctx, 1, (int[]){ -1 }, 0);
+      debug_window_labelf(ctx, "%.3f ms, %.0f fps, tick %llu (F4 writes %s)",
+          last_ms, last_ms > 0 ? 1000.0 / last_ms : 0, (unsigned long long)gp->tick_index, TRACE_PATH);
+
+      mu_layout_row(ctx, 1, (int[]){ -1 }, DEBUG_WINDOW_GRAPH_HEIGHT);
+      mu_Rect graph = mu_layout_next(ctx);
+      mu_draw_rect(ctx, graph, ctx->style->colors[MU_COLOR_BASE]);
+
+      /* newest frame on the right, the line is the target frame time at half height */
+      s32 bar_w = MAX(1, graph.w / PROF_FRAMES);
+
+      for(u64 ago = 0; ago < PROF_FRAMES; ago++) {
+        Prof_frame *frame = prof_frame_ago(ago);
+        if(!frame) break;
+
+        f64 ms = (f64)(frame->end_ns - frame->begin_ns) * 1e-6;
+        s32 h = (s32)((f64)graph.h * MIN(0.5 * ms / target_ms, 1.0));
+        s32 x = graph.x + graph.w - (s32)(ago + 1) * bar_w;
+        if(x < graph.x) break;
+
+        mu_Color color = ms > 1.05 * target_ms ? mu_color(230, 41, 55, 255) : mu_color(0, 228, 48, 255);
+        mu_draw_rect(ctx, mu_rect(x, graph.y + graph.h - h, MAX(1, bar_w - 1), h), color);
+      }
+
+      mu_draw_rect(ctx, mu_rect(graph.x, graph.y + graph.h/2, graph.w, 1), mu_color(253, 249, 0, 255));
+    } /* frame */
+
+    if(mu_header_ex(ctx, "zones", MU_OPT_EXPANDED)) { /* zones */
+      Prof_frame *last = prof_last_frame();
+
+      if(last) {
+        mu_layout_row(ctx, 2, (int[]){ -80, -1 }, 0);
+
+        for(s32 i = 0; i < last->zones_count; i++) {
+          Prof_zone *zone = &last->zones[i];
+          debug_window_labelf(ctx, "%*s%s", (int)(2 * zone->depth), "", zone->name);
+          debug_window_labelf(ctx, "%.3f ms", (f64)(zone->end_ns - zone->begin_ns) * 1e-6);
+        }
+
+        if(last->zones_dropped) {
+          debug_window_labelf(ctx, "dropped");
+          debug_window_labelf(ctx, "%i", last->zones_dropped);
+        }
+      }
+    } /* zones */
+
+    if(mu_header_ex(ctx, "arenas", MU_OPT_EXPANDED)) { /* arenas */
+      for(s32 i = 0; i < arena_registry.count; i++) {
+        Arena *arena = arena_registry.arenas[i];
+        Arena_stats *stats = &arena->stats;
+        u64 cap = arena->cur->base_pos + arena->cur->size;
+
+        mu_layout_row(ctx, 3, (int[]){ 80, 120, -1 }, 0);
+        debug_window_usage(ctx, arena_registry.names[i], arena_pos(arena) >> 10, cap >> 10, " KB");
+
+        /* zero unless ARENA_STATS */
+        mu_layout_row(ctx, 1, (int[]){ -1 }, 0);
+        debug_window_labelf(ctx, "  peak %llu KB, chained %u, reused %u, commits %u, align %llu B",
+            (unsigned long long)(stats->peak_pos >> 10), stats->chain_count, stats->free_list_hits,
+            stats->commit_count, (unsigned long long)stats->align_waste);
+      }
+    } /* arenas */
+
+    if(mu_header_ex(ctx, "entities", MU_OPT_EXPANDED)) { /* entities */
+      s32 kind_counts[ENTITY_KIND_MAX] = {0};
+
+      for(Entity_order order = ENTITY_ORDER_FIRST; order < ENTITY_ORDER_MAX; order++) {
+        Slice(Entity_ptr) list = gp->update_lists[order];
+        for(s64 i = 0; i < list.count; i++) {
+          kind_counts[list.d[i]->kind]++;
+        }
+      }
+
+      mu_layout_row(ctx, 3, (int[]){ 80, 120, -1 }, 0);
+      debug_window_usage(ctx, "live", (u64)gp->live_entities, MAX_ENTITIES, "");
+      debug_window_usage(ctx, "allocated", (u64)gp->entities_allocated, MAX_ENTITIES, "");
+
+      mu_layout_row(ctx, 2, (int[]){ -80, -1 }, 0);
+      debug_window_labelf(ctx, "enemies");
+      debug_window_labelf(ctx, "%i", gp->live_enemies);
+
+      for(Entity_kind kind = 0; kind < ENTITY_KIND_MAX; kind++) {
+        if(kind_counts[kind] == 0) continue;
+        debug_window_labelf(ctx, "%s", Entity_kind_strings[kind]);
+        debug_window_labelf(ctx, "%i", kind_counts[kind]);
+      }
+    } /* entities */
+
+    if(mu_header_ex(ctx, "pools", MU_OPT_EXPANDED)) { /* pools */
+      mu_layout_row(ctx, 3, (int[]){ 80, 120, -1 }, 0);
+      debug_window_usage(ctx, "particles", gp->live_particles, MAX_PARTICLES, "");
+      debug_window_usage(ctx, "projectiles", (u64)gp->projectiles_count, MAX_PROJECTILES, "");
+      debug_window_usage(ctx, "list nodes", (u64)gp->entity_node_pool.live_count, (u64)gp->entity_node_pool.slots_count, "");
+      debug_window_usage(ctx, "waypoints", (u64)gp->waypoint_pool.live_count, (u64)gp->waypoint_pool.slots_count, "");
+    } /* pools */
+
+    if(mu_header_ex(ctx, "collision", MU_OPT_EXPANDED)) { /* collision */
+      mu_layout_row(ctx, 2, (int[]){ -80, -1 }, 0);
+
+      for(Collision_counter counter = 0; counter < COLLISION_COUNTER_MAX; counter++) {
+        debug_window_labelf(ctx, "%s", Collision_counter_strings[counter]);
+        debug_window_labelf(ctx, "%u", gp->collision_counts[counter]);
+      }
+    } /* collision */
+
+    if(mu_header_ex(ctx, "game", 0)) { /* game */
+      mu_layout_row(ctx, 2, (int[]){ 120, -1 }, 0);
+
+      debug_window_labelf(ctx, "state");
+      debug_window_labelf(ctx, "%s", Game_state_strings[gp->state]);
+      debug_window_labelf(ctx, "level");
+      debug_window_labelf(ctx, "%i phase %i", gp->level+1, gp->phase_index+1);
+      debug_window_labelf(ctx, "player pos");
+      debug_window_labelf(ctx, "%.1f %.1f", gp->player ? gp->player->pos.x : 0, gp->player ? gp->player->pos.y : 0);
+      debug_window_labelf(ctx, "sound");
+      debug_window_labelf(ctx, "%s", (gp->debug_flags & GAME_DEBUG_FLAG_MUTE) ? "off" : "on");
+      debug_window_labelf(ctx, "invincible");
+      debug_window_labelf(ctx, "%s", (gp->debug_flags & GAME_DEBUG_FLAG_PLAYER_INVINCIBLE) ? "on" : "off");
+      debug_window_labelf(ctx, "editor tool");
+      debug_window_labelf(ctx, "%i %s", (int)gp->editor.tool, Editor_tool_strings[gp->editor.tool]);
+      debug_window_labelf(ctx, "replay");
+      debug_window_labelf(ctx, "%s %lli/%u", Replay_mode_strings[gp->replay.mode],
+          (long long)(gp->replay.mode == REPLAY_MODE_PLAYBACK ? gp->replay.tick_index : 0),
+          gp->replay.header.ticks_count);
+      debug_window_labelf(ctx, "screen");
+      debug_window_labelf(ctx, "%ix%i", GetScreenWidth(), GetScreenHeight());
+      debug_window_labelf(ctx, "render");
+      debug_window_labelf(ctx, "%ix%i", GetRenderWidth(), GetRenderHeight());
+    } /* game */
+
+    mu_end_window(ctx);
+  }
+
+  mu_end(ctx);
+
+  murl_render(ctx);
+}
+#endif
+
 force_inline s64 tile_from_point(Vector2 p) {
 
-  s64 col = Clamp((s64)(p.x * INV_TILE_SIZE), 0, MAP_WIDTH);
-  s64 row = Clamp((s64)(p.y * INV_TILE_SIZE), 0, MAP_HEIGHT);
+  s64 col = Clamp((s64)(p.x * INV_TILE_SIZE), 0, TILE_COLS - 1);
+  s64 row = Clamp((s64)(p.y * INV_TILE_SIZE), 0, TILE_ROWS - 1);
 
   s64 tile = col + row * TILE_COLS;
 
@@ -2568,6 +4213,144 @@ force_inline void row_col_from_tile(s64 tile, s64 *row, s64 *col) {
   *row = tile / TILE_ROWS;
 }
 
+force_inline s64 tile_chunk_from_tile(s64 tile) {
+  s64 row, col;
+  row_col_from_tile(tile, &row, &col);
+
+  s64 chunk = col / TILE_CHUNK_SIZE + (row / TILE_CHUNK_SIZE) * TILE_CHUNK_COLS;
+
+  return chunk;
+}
+
+/* all tile writes that should show up on screen go through here */
+force_inline void tile_set(Game *gp, u8 *tiles, s64 tile, Tile_kind kind) {
+  ASSERT(tile >= 0 && tile < TILES_COUNT);
+
+  if(tiles[tile] != kind) {
+    tiles[tile] = kind;
+    gp->tile_chunk_dirty[tile_chunk_from_tile(tile)] = 1;
+  }
+
+}
+
+void tile_chunks_mark_all_dirty(Game *gp) {
+  memory_set(gp->tile_chunk_dirty, 1, sizeof(gp->tile_chunk_dirty));
+}
+
+void tile_chunk_bake(Game *gp, u8 *tiles, s64 chunk) {
+  Color pixels[TILE_CHUNK_SIZE*TILE_CHUNK_SIZE];
+
+  s64 first_col = (chunk % TILE_CHUNK_COLS) * TILE_CHUNK_SIZE;
+  s64 first_row = (chunk / TILE_CHUNK_COLS) * TILE_CHUNK_SIZE;
+
+  for(s64 y = 0; y < TILE_CHUNK_SIZE; y++) {
+    u8 *tile_row = tiles + first_col + (first_row + y) * TILE_COLS;
+
+    for(s64 x = 0; x < TILE_CHUNK_SIZE; x++) {
+      Color color = BLANK;
+
+      switch(tile_row[x]) {
+        case TILE_KIND_WALL:
+          color = SKYBLUE;
+          break;
+        case TILE_KIND_FLOOR:
+          color = GRAY;
+          break;
+        case TILE_KIND_RED_DOOR:
+          color = RED;
+          break;
+      }
+
+      pixels[x + y * TILE_CHUNK_SIZE] = color;
+    }
+
+  }
+
+  UpdateTexture(gp->tile_chunk_textures[chunk], pixels);
+  gp->tile_chunk_dirty[chunk] = 0;
+}
+
+void tile_chunks_draw(Game *gp, u8 *tiles) {
+
+  if(gp->tile_chunks_source != tiles) {
+    gp->tile_chunks_source = tiles;
+    tile_chunks_mark_all_dirty(gp);
+  }
+
+  Rectangle view = gp->cam_view_rect;
+
+  float chunk_world_size = (float)(TILE_CHUNK_SIZE * TILE_SIZE);
+
+  s64 first_col = (s64)Clamp(floorf(view.x / chunk_world_size), 0, TILE_CHUNK_COLS);
+  s64 first_row = (s64)Clamp(floorf(view.y / chunk_world_size), 0, TILE_CHUNK_ROWS);
+  s64 last_col  = (s64)Clamp(ceilf((view.x + view.width) / chunk_world_size), 0, TILE_CHUNK_COLS);
+  s64 last_row  = (s64)Clamp(ceilf((view.y + view.height) / chunk_world_size), 0, TILE_CHUNK_ROWS);
+
+  Rectangle src = { 0, 0, TILE_CHUNK_SIZE, TILE_CHUNK_SIZE };
+
+  for(s64 row = first_row; row < last_row; row++) {
+    for(s64 col = first_col; col < last_col; col++) {
+      s64 chunk = col + row * TILE_CHUNK_COLS;
+
+      if(gp->tile_chunk_dirty[chunk]) {
+        tile_chunk_bake(gp, tiles, chunk);
+      }
+
+      Rectangle dst =
+      {
+        .x = (float)col * chunk_world_size,
+        .y = (float)row * chunk_world_size,
+        .width = chunk_world_size,
+        .height = chunk_world_size,
+      };
+
+      DrawTexturePro(gp->tile_chunk_textures[chunk], src, dst, (Vector2){0}, 0, WHITE);
+    }
+  }
+
+}
+
+/* radius of everything draw_entity can put on screen around ep->pos */
+float entity_draw_radius(Entity *ep) {
+  float radius = MAX(ep->radius, ep->interact_radius);
+
+  if(ep->flags & ENTITY_FLAG_HAS_SPRITE) {
+    Sprite_frame frame = sprite_current_frame(ep->sprite);
+    float sprite_radius = 0.5f*ep->sprite_scale*sqrtf((float)(frame.w*frame.w + frame.h*frame.h));
+    radius = MAX(radius, sprite_radius + Vector2Length(ep->sprite_offset));
+  }
+
+  return radius;
+}
+
+Vector2 entity_draw_pos(Game *gp, Entity *ep) {
+  if(!ep->has_prev_state) return ep->pos;
+  return Vector2Lerp(ep->prev_pos, ep->pos, gp->sim_alpha);
+}
+
+/* turns the short way round */
+f32 entity_draw_look_angle(Game *gp, Entity *ep) {
+  if(!ep->has_prev_state) return ep->look_angle;
+  f32 turn = Wrap(ep->look_angle - ep->prev_look_angle, -PI, PI);
+  return ep->look_angle - (1.0f - gp->sim_alpha) * turn;
+}
+
+/* world space rectangle seen through cam */
+Rectangle camera_view_rect(Camera2D cam) {
+  Vector2 min = GetScreenToWorld2D((Vector2){ 0, 0 }, cam);
+  Vector2 max = GetScreenToWorld2D(WINDOW_SIZE, cam);
+
+  Rectangle rect =
+  {
+    .x = MIN(min.x, max.x),
+    .y = MIN(min.y, max.y),
+    .width = fabsf(max.x - min.x),
+    .height = fabsf(max.y - min.y),
+  };
+
+  return rect;
+}
+
 Collision_manifold tile_segment_intersect(Vector2 p1, Vector2 p2, Vector2 p3, Vector2 p4) {
   float numerator_t = 0, numerator_u = 0, denominator = 0;
 
@@ -2692,6 +4475,32 @@ void game_main_loop(Game *gp) {
 
 void game_update_and_draw(Game *gp) {
 
+  prof_frame_begin();
+
+  PROF_ZONE("update") game_update(gp);
+
+  if(gp->quit) {
+    prof_frame_end();
+    return;
+  }
+
+  PROF_ZONE("camera") camera_update(gp);
+
+  /* headless builds only simulate, camera_update above is all the update needs from drawing */
+#ifndef HEADLESS
+  PROF_ZONE("draw") game_draw(gp);
+#endif
+
+  gp->frame_index++;
+
+  arena_clear(gp->frame_arena);
+
+  prof_frame_end();
+
+}
+
+void game_update(Game *gp) {
+
   if(IsMusicStreamPlaying(gp->music)) {
     if(GetMusicTimePlayed(gp->music) >= 160.58f) {
       SeekMusicStream(gp->music, 32.630f);
@@ -2701,28 +4510,20 @@ void game_update_and_draw(Game *gp) {
     UpdateMusicStream(gp->music);
   }
 
-#ifdef DEBUG
-  gp->dt = Clamp(1.0f/50.0f, 1.0f/TARGET_FPS, GetFrameTime());
-#else
-  gp->dt = Clamp(1.0f/10.0f, 1.0f/TARGET_FPS, GetFrameTime());
-#endif
-
-  gp->next_state = gp->state;
+  gp->dt = SIM_DT;
+  gp->frame_dt = GetFrameTime();
 
-  {
-    Entity *player = entity_from_handle(gp->player_handle);
-    if(player) {
-      gp->player = player;
-    }
-  }
+  memory_zero(gp->collision_counts, sizeof(gp->collision_counts));
+  gp->sim_accumulator += gp->frame_dt;
 
   if(WindowShouldClose()) {
     gp->quit = 1;
     return;
   }
 
+  PROF_ZONE("input")
   { /* get input */
-    gp->input_flags = 0;
+    gp->input_flags &= ~INPUT_FLAG_HELD;
 
     if(IsKeyDown(KEY_W)) {
       gp->input_flags |= INPUT_FLAG_MOVE_FORWARD;
@@ -2778,6 +4579,26 @@ void game_update_and_draw(Game *gp) {
       game_reset(gp);
     }
 
+    if(IsKeyPressed(KEY_F2)) {
+      if(gp->replay.mode == REPLAY_MODE_RECORD) {
+        replay_stop(gp);
+      } else {
+        replay_record_begin(gp);
+      }
+    }
+
+    if(IsKeyPressed(KEY_F3)) {
+      if(gp->replay.mode == REPLAY_MODE_PLAYBACK) {
+        replay_stop(gp);
+      } else {
+        replay_playback_begin(gp, REPLAY_PATH);
+      }
+    }
+
+    if(IsKeyPressed(KEY_F4)) {
+      trace_write(gp, TRACE_PATH);
+    }
+
     if(IsKeyPressed(KEY_F11)) {
       gp->debug_flags  ^= GAME_DEBUG_FLAG_DEBUG_UI;
     }
@@ -2800,6 +4621,8 @@ void game_update_and_draw(Game *gp) {
 
 #endif
 
+    gp->mouse_pos = GetMousePosition();
+
     int key = PeekCharPressed();
     gp->key_pressed = key;
     gp->character_pressed = key;
@@ -2809,13 +4632,39 @@ void game_update_and_draw(Game *gp) {
 
   } /* get input */
 
-
-  if(gp->input_flags & INPUT_FLAG_PAUSE) {
-    gp->flags ^= GAME_FLAG_PAUSE;
+#ifdef DEBUG
+  if(gp->debug_flags & GAME_DEBUG_FLAG_EDITOR) {
+    /* the editor reads mouse deltas and wheel moves, it has to run exactly once per frame */
+    gp->sim_accumulator = SIM_DT;
   }
+#endif
 
+  for(s32 tick = 0; tick < MAX_SIM_TICKS_PER_FRAME && gp->sim_accumulator >= SIM_DT; tick++)
   { /* update */
 
+    gp->sim_accumulator -= SIM_DT;
+    gp->tick_index++;
+
+    /* the tick is left with goto update_end, its zone is closed by hand there */
+    prof_zone_begin("tick");
+
+    replay_tick_input(gp);
+
+    gp->next_state = gp->state;
+
+    {
+      Entity *player = entity_from_handle(gp, gp->player_handle);
+      if(player) {
+        gp->player = player;
+      }
+    }
+
+    gp->sim_view_rect = camera_sim_view_rect(gp);
+
+    if(gp->input_flags & INPUT_FLAG_PAUSE) {
+      gp->flags ^= GAME_FLAG_PAUSE;
+    }
+
     if(is_valid_handle(gp->player_handle)) {
       if(!gp->player) {
         gp->next_state = GAME_STATE_GAME_OVER;
@@ -2851,8 +4700,9 @@ void game_update_and_draw(Game *gp) {
         float progress = gp->cam_shake.timer / gp->cam_shake.duration;
         float intensity = gp->cam_shake.magnitude * (1.0f - progress);
 
-        gp->cam_shake.offset.x = ((float)GetRandomValue(-100, 100) / 100.0f) * intensity;
-        gp->cam_shake.offset.y = ((float)GetRandomValue(-100, 100) / 100.0f) * intensity;
+        Rng *rng = &gp->rng[RNG_STREAM_COSMETIC];
+        gp->cam_shake.offset.x = rng_range_f32(rng, -1.0f, 1.0f) * intensity;
+        gp->cam_shake.offset.y = rng_range_f32(rng, -1.0f, 1.0f) * intensity;
       }
 
     }
@@ -2995,14 +4845,14 @@ void game_update_and_draw(Game *gp) {
 
           if(!gp->player) {
             Entity *player = spawn_player(gp);
-            gp->player_handle = handle_from_entity(player);
+            gp->player_handle = handle_from_entity(gp, player);
 
             gp->flags |=
               GAME_FLAG_DRAW_IN_CAMERA |
               0;
 
-          } else {
-
+          } else if(gp->scenario.kind != SCENARIO_NONE) {
+            PROF_ZONE("scenario") scenario_tick(gp);
           }
 
         } break;
@@ -3077,13 +4927,11 @@ void game_update_and_draw(Game *gp) {
 
             if(IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
 
-              ASSERT(editor->tile >= 0 && editor->tile <= TILES_COUNT);
-              editor->tiles[editor->tile] = TILE_KIND_WALL;
+              tile_set(gp, editor->tiles, editor->tile, TILE_KIND_WALL);
 
             } else if(IsMouseButtonDown(MOUSE_BUTTON_RIGHT)) {
 
-              ASSERT(editor->tile >= 0 && editor->tile <= TILES_COUNT);
-              editor->tiles[editor->tile] = TILE_KIND_NONE;
+              tile_set(gp, editor->tiles, editor->tile, TILE_KIND_NONE);
 
             }
 
@@ -3094,13 +4942,11 @@ void game_update_and_draw(Game *gp) {
 
             if(IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
 
-              ASSERT(editor->tile >= 0 && editor->tile <= TILES_COUNT);
-              editor->tiles[editor->tile] = TILE_KIND_FLOOR;
+              tile_set(gp, editor->tiles, editor->tile, TILE_KIND_FLOOR);
 
             } else if(IsMouseButtonDown(MOUSE_BUTTON_RIGHT)) {
 
-              ASSERT(editor->tile >= 0 && editor->tile <= TILES_COUNT);
-              editor->tiles[editor->tile] = TILE_KIND_NONE;
+              tile_set(gp, editor->tiles, editor->tile, TILE_KIND_NONE);
 
             }
 
@@ -3129,15 +4975,13 @@ void game_update_and_draw(Game *gp) {
 
               } else {
 
-                ASSERT(editor->tile >= 0 && editor->tile <= TILES_COUNT);
-                editor->tiles[editor->tile] = tile_from_door_tool(tool);
+                tile_set(gp, editor->tiles, editor->tile, tile_from_door_tool(tool));
 
               }
 
             } else if(IsMouseButtonDown(MOUSE_BUTTON_RIGHT)) {
 
-              ASSERT(editor->tile >= 0 && editor->tile <= TILES_COUNT);
-              editor->tiles[editor->tile] = TILE_KIND_NONE;
+              tile_set(gp, editor->tiles, editor->tile, TILE_KIND_NONE);
 
             }
 
@@ -3168,22 +5012,13 @@ void game_update_and_draw(Game *gp) {
               arr_push(editor->static_entities, ep);
 
             } else if(IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
-              Arr_Entity_ptr static_entities;
-              arr_init_ex(static_entities, gp->frame_arena, editor->static_entities.count);
-
-              for(int i = 0; i < editor->static_entities.count; i++) {
+              for(s64 i = editor->static_entities.count - 1; i >= 0; i--) {
                 Entity *ep = editor->static_entities.d[i];
                 if(tile_from_point(ep->pos) == editor->tile) {
                   entity_die(gp, ep);
-                } else {
-                  arr_push(static_entities, ep);
+                  arr_del(editor->static_entities, i);
                 }
               }
-
-              editor->static_entities.count = 0;
-              for(int i = 0; i < static_entities.count; i++) {
-                arr_push(editor->static_entities, static_entities.d[i]);
-              }
             }
 
           } break;
@@ -3199,22 +5034,13 @@ void game_update_and_draw(Game *gp) {
               arr_push(editor->static_entities, ep);
 
             } else if(IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
-              Arr_Entity_ptr static_entities;
-              arr_init_ex(static_entities, gp->frame_arena, editor->static_entities.count);
-
-              for(int i = 0; i < editor->static_entities.count; i++) {
+              for(s64 i = editor->static_entities.count - 1; i >= 0; i--) {
                 Entity *ep = editor->static_entities.d[i];
                 if(tile_from_point(ep->pos) == editor->tile) {
                   entity_die(gp, ep);
-                } else {
-                  arr_push(static_entities, ep);
+                  arr_del(editor->static_entities, i);
                 }
               }
-
-              editor->static_entities.count = 0;
-              for(int i = 0; i < static_entities.count; i++) {
-                arr_push(editor->static_entities, static_entities.d[i]);
-              }
             }
 
           } break;
@@ -3229,22 +5055,13 @@ void game_update_and_draw(Game *gp) {
               arr_push(editor->static_entities, ep);
 
             } else if(IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
-              Arr_Entity_ptr static_entities;
-              arr_init_ex(static_entities, gp->frame_arena, editor->static_entities.count);
-
-              for(int i = 0; i < editor->static_entities.count; i++) {
+              for(s64 i = editor->static_entities.count - 1; i >= 0; i--) {
                 Entity *ep = editor->static_entities.d[i];
                 if(tile_from_point(ep->pos) == editor->tile) {
                   entity_die(gp, ep);
-                } else {
-                  arr_push(static_entities, ep);
+                  arr_del(editor->static_entities, i);
                 }
               }
-
-              editor->static_entities.count = 0;
-              for(int i = 0; i < static_entities.count; i++) {
-                arr_push(editor->static_entities, static_entities.d[i]);
-              }
             }
 
           } break;
@@ -3259,39 +5076,82 @@ void game_update_and_draw(Game *gp) {
     gp->live_entities = 0;
     gp->live_enemies = 0;
 
+    PROF_ZONE("spatial grid") spatial_grid_build(gp);
+
+    /* projectiles run before the FIRST order, where entity bullets used to */
+    PROF_ZONE("projectiles") projectiles_update(gp);
+
+    PROF_ZONE("entities")
     for(Entity_order order = ENTITY_ORDER_FIRST; order < ENTITY_ORDER_MAX; order++) {
 
-      for(int i = 0; i < gp->entities_allocated; i++)
-      { /* update_entities */
+      /* snapshot the list, entities spawned during this pass are updated next frame */
+      Slice(Entity_ptr) update_list = gp->update_lists[order];
+      Slice(Entity_ptr) entities = { .d = frame_push_array_no_zero(Entity_ptr, update_list.count + 1) };
 
-        Entity *ep = &gp->entities[i];
+      for(s64 i = 0; i < update_list.count; i++) {
+        Entity *ep = update_list.d[i];
 
-        if(ep->live && ep->update_order == order)
-        { /* entity_update */
+        ASSERT(ep->live && ep->update_order == order);
 
-          gp->live_entities++;
+        entities.d[entities.count++] = ep;
 
-          if(entity_kind_in_mask(ep->kind, ENEMY_KIND_MASK)) {
-            gp->live_enemies++;
-          }
+        gp->live_entities++;
+
+        if(entity_kind_in_mask(ep->kind, ENEMY_KIND_MASK)) {
+          gp->live_enemies++;
+        }
+
+        ep->applied_collision = 0;
+        ep->on_screen = CheckCollisionCircleRec(ep->pos, ep->radius, gp->sim_view_rect);
+        ep->fully_on_screen = check_circle_all_inside_rec(ep->pos, ep->radius, gp->sim_view_rect);
+        ep->prev_pos = ep->pos;
+        ep->prev_look_angle = ep->look_angle;
+        ep->has_prev_state = 1;
+      }
+
+      PROF_ZONE("control")
+      { /* control */
+
+        /* bucket by control with a counting sort so each handler runs as one loop */
+        s64 control_counts[ENTITY_CONTROL_MAX + 1] = {0};
+
+        for(s64 i = 0; i < entities.count; i++) {
+          control_counts[entities.d[i]->control + 1]++;
+        }
+
+        for(s64 control = 1; control <= ENTITY_CONTROL_MAX; control++) {
+          control_counts[control] += control_counts[control - 1];
+        }
+
+        Entity **by_control = frame_push_array_no_zero(Entity_ptr, entities.count + 1);
+        s64 control_offsets[ENTITY_CONTROL_MAX];
+        memory_copy(control_offsets, control_counts, sizeof(control_offsets));
+
+        for(s64 i = 0; i < entities.count; i++) {
+          Entity *ep = entities.d[i];
+          by_control[control_offsets[ep->control]++] = ep;
+        }
+
+        for(Entity_control control = ENTITY_CONTROL_NONE + 1; control < ENTITY_CONTROL_MAX; control++) {
+
+          Slice(Entity_ptr) batch = {
+            .d = by_control + control_counts[control],
+            .count = control_counts[control + 1] - control_counts[control],
+          };
 
-          b8 applied_collision = 0;
-          b8 is_on_screen = CheckCollisionCircleRec(ep->pos, ep->radius, WINDOW_RECT);
-          b8 is_fully_on_screen = check_circle_all_inside_rec(ep->pos, ep->radius, WINDOW_RECT);
-          Vector2 old_pos = ep->pos;
+          if(batch.count == 0) continue;
 
-          switch(ep->control) {
+          switch(control) {
             default:
               UNREACHABLE;
-            case ENTITY_CONTROL_NONE:
-              break;
             case ENTITY_CONTROL_PLAYER:
-              {
+              for(s64 i = 0; i < batch.count; i++) {
+                Entity *ep = batch.d[i];
 
                 { /* mouse look */
 
                   Vector2 center = { WINDOW_WIDTH * 0.5f, WINDOW_HEIGHT * 0.5f };
-                  Vector2 mouse_pos = GetMousePosition();
+                  Vector2 mouse_pos = gp->mouse_pos;
                   Vector2 look_dir = Vector2Subtract(mouse_pos, center);
                   float len = Vector2Length(look_dir);
 
@@ -3363,17 +5223,19 @@ void game_update_and_draw(Game *gp) {
                   }
                 }
 
-                Entity *gun = entity_from_handle(ep->holding_gun_handle);
+                Entity *gun = entity_from_handle(gp, ep->holding_gun_handle);
                 if(gun) {
 
-                  if(gun->gun.flags & GUN_FLAG_AUTOMATIC) {
+                  Gun *held_gun = &entity_cold(gp, gun)->gun;
+
+                  if(held_gun->flags & GUN_FLAG_AUTOMATIC) {
                     if(gp->input_flags & INPUT_FLAG_SHOOT_HOLD) {
-                      gun->gun.shoot = 1;
+                      held_gun->shoot = 1;
                     }
                   } else {
                     if(gp->input_flags & INPUT_FLAG_SHOOT) {
 
-                      gun->gun.shoot = 1;
+                      held_gun->shoot = 1;
 
                       //camera_shake(gp, 0.15, 1.8f);
                       //camera_shake(gp, 0.1f, 1.0f);
@@ -3396,7 +5258,7 @@ void game_update_and_draw(Game *gp) {
 
                 if(gp->input_flags & INPUT_FLAG_THROW) {
 
-                  Entity *holding = entity_from_handle(ep->holding_gun_handle);
+                  Entity *holding = entity_from_handle(gp, ep->holding_gun_handle);
 
                   if(holding) {
                     holding->flags ^=
@@ -3411,12 +5273,13 @@ void game_update_and_draw(Game *gp) {
                       ENTITY_FLAG_IS_INTERACTABLE |
                       0;
 
+                    holding->flags &= ~ENTITY_FLAG_FOLLOW_HOLDER;
                     holding->control = ENTITY_CONTROL_NONE;
                     holding->parent_handle = (Entity_handle){0};
                     holding->vel = Vector2Scale(ep->look_dir, 1100);
                     holding->spin_vel = PI*6.5f;
                     holding->friction = 1.0f;
-                    holding->damage_amount = holding->gun.bullet_damage << 2;
+                    holding->damage_amount = entity_cold(gp, holding)->gun.bullet_damage << 2;
                     holding->life_time_duration = 0.23f;
                     holding->apply_collision_mask =
                       ENTITY_KIND_MASK_RAPTOR |
@@ -3430,41 +5293,48 @@ void game_update_and_draw(Game *gp) {
                   ep->received_damage = 0;
                 }
 
-              } break;
+              }
+              break;
             case ENTITY_CONTROL_GUN_ON_GROUND:
-              {
+              for(s64 i = 0; i < batch.count; i++) {
+                Entity *ep = batch.d[i];
 
-                b32 jammed = !!(GetRandomValue(0, 100) >= 30);
+                b32 jammed = !!(rng_range_s32(&gp->rng[RNG_STREAM_GAMEPLAY], 0, 100) >= 30);
 
                 if(jammed) {
-                  ep->gun.flags |= GUN_FLAG_JAMMED;
+                  entity_cold(gp, ep)->gun.flags |= GUN_FLAG_JAMMED;
                 } else {
-                  ep->gun.flags &= ~GUN_FLAG_JAMMED;
+                  entity_cold(gp, ep)->gun.flags &= ~GUN_FLAG_JAMMED;
                 }
 
-              } break;
+              }
+              break;
             case ENTITY_CONTROL_GUN_BEING_HELD:
-              {
-                Entity *parent = entity_from_handle(ep->parent_handle);
+              for(s64 i = 0; i < batch.count; i++) {
+                Entity *ep = batch.d[i];
+
+                /* thrown by its holder earlier in this pass */
+                if(ep->control != ENTITY_CONTROL_GUN_BEING_HELD) continue;
+
+                Entity *parent = entity_from_handle(gp, ep->parent_handle);
 
                 ep->look_dir = parent->look_dir;
                 ep->look_angle = parent->look_angle;
-
-                float angle = parent->look_angle;
                 ep->sprite_rotation = parent->sprite_rotation;
-                ep->manual_sprite_origin = parent->pos;
-                Vector2 offset = Vector2Rotate(ep->being_held_offset, angle);
-                ep->pos = Vector2Add(parent->pos, offset);
 
-              } break;
+              }
+              break;
             case ENTITY_CONTROL_DOOR:
-              {
+              for(s64 i = 0; i < batch.count; i++) {
+                Entity *ep = batch.d[i];
+
                 if(gp->player) {
                   Door_color door_color = ep->door_color;
+                  Entity_cold *cold = entity_cold(gp, ep);
 
                   bool open_door = false;
-                  for(int i = 0; i < ep->door_tiles_count; i++) {
-                    if(tile_distance(ep->door_tiles[i], tile_from_point(gp->player->pos)) <= 2) {
+                  for(int i = 0; i < cold->door_tiles_count; i++) {
+                    if(tile_distance(cold->door_tiles[i], tile_from_point(gp->player->pos)) <= 2) {
                       if(gp->input_flags & INPUT_FLAG_INTERACT) {
                         if(door_color_in_mask(door_color, gp->keys)) {
                           open_door = true;
@@ -3475,8 +5345,8 @@ void game_update_and_draw(Game *gp) {
                   }
 
                   if(open_door) {
-                    for(int i = 0; i < ep->door_tiles_count; i++) {
-                      gp->tiles[ep->door_tiles[i]] = TILE_KIND_FLOOR;
+                    for(int i = 0; i < cold->door_tiles_count; i++) {
+                      tile_set(gp, gp->tiles, cold->door_tiles[i], TILE_KIND_FLOOR);
                     }
 
                     ep->flags |= ENTITY_FLAG_DIE_NOW;
@@ -3484,30 +5354,40 @@ void game_update_and_draw(Game *gp) {
 
                 }
 
-              } break;
+              }
+              break;
             case ENTITY_CONTROL_COPY_PARENT:
-              {
-                Entity *parent = entity_from_handle(ep->parent_handle);
+              for(s64 i = 0; i < batch.count; i++) {
+                Entity *ep = batch.d[i];
+
+                Entity *parent = entity_from_handle(gp, ep->parent_handle);
                 ASSERT(parent);
 
                 ep->vel = parent->vel;
 
-              } break;
+              }
+              break;
             case ENTITY_CONTROL_FOLLOW_PARENT:
-              {
-                Entity *parent = entity_from_handle(ep->parent_handle);
+              for(s64 i = 0; i < batch.count; i++) {
+                Entity *ep = batch.d[i];
+
+                Entity *parent = entity_from_handle(gp, ep->parent_handle);
                 ASSERT(parent);
 
                 Vector2 dir = Vector2Normalize(Vector2Subtract(parent->pos, ep->pos));
                 ep->vel = Vector2Scale(dir, ep->scalar_vel);
 
-              } break;
+              }
+              break;
             case ENTITY_CONTROL_GOTO_WAYPOINT:
-              {
-                ASSERT(ep->waypoints.first && ep->waypoints.last);
-                Waypoint *wp = ep->cur_waypoint;
+              for(s64 i = 0; i < batch.count; i++) {
+                Entity *ep = batch.d[i];
+
+                Entity_cold *cold = entity_cold(gp, ep);
+                ASSERT(cold->waypoints.first && cold->waypoints.last);
+                Waypoint *wp = cold->cur_waypoint;
                 if(!wp) {
-                  wp = ep->waypoints.first;
+                  wp = cold->waypoints.first;
                 }
 
                 Vector2 dir = Vector2Subtract(wp->pos, ep->pos);
@@ -3515,11 +5395,11 @@ void game_update_and_draw(Game *gp) {
 
                 if(dir_len_sqr < SQUARE(wp->radius)) {
                   if(!wp->next) {
-                    if(ep->waypoints.action) {
-                      ep->waypoints.action(gp, ep);
+                    if(cold->waypoints.action) {
+                      cold->waypoints.action(gp, ep);
                     }
                   } else {
-                    ep->cur_waypoint = wp->next;
+                    cold->cur_waypoint = wp->next;
                   }
                 } else {
                   float dir_len = sqrtf(dir_len_sqr);
@@ -3527,199 +5407,314 @@ void game_update_and_draw(Game *gp) {
                   ep->vel = dir;
                 }
 
-              } break;
+              }
+              break;
           }
 
-          /* entity flags stuff */
+        }
+
+      } /* control */
 
-          if(ep->flags & ENTITY_FLAG_APPLY_FRICTION) {
-            ep->vel = Vector2Subtract(ep->vel, Vector2Scale(ep->vel, ep->friction*gp->dt));
-          }
+      Entity **system_batch = frame_push_array_no_zero(Entity_ptr, entities.count + 1);
 
-          if(ep->flags & ENTITY_FLAG_DYNAMICS) {
-            Vector2 a_times_t = Vector2Scale(ep->accel, gp->dt);
-            ep->vel = Vector2Add(ep->vel, a_times_t);
-            ep->pos = Vector2Add(ep->pos, Vector2Add(Vector2Scale(ep->vel, gp->dt), Vector2Scale(a_times_t, 0.5*gp->dt)));
-          }
+      PROF_ZONE("systems")
+      for(Entity_system system = 0; system < ENTITY_SYSTEM_MAX; system++)
+      { /* systems */
 
-          if(ep->flags & ENTITY_FLAG_SPINNING) {
-            float turn = ep->spin_vel * gp->dt;
-            ep->look_angle += turn;
-            //ep->look_dir = Vector2Rotate(ep->look_dir, turn);
-          }
+        /* gather right before running, earlier systems set flags later ones test */
+        Entity_flags system_flag = Entity_system_flags[system];
+        Slice(Entity_ptr) batch = { .d = system_batch };
+
+        for(s64 i = 0; i < entities.count; i++) {
+          Entity *ep = entities.d[i];
+          batch.d[batch.count] = ep;
+          batch.count += !!(ep->flags & system_flag);
+        }
+
+        if(batch.count == 0) continue;
+
+        PROF_ZONE(Entity_system_strings[system])
+        switch(system) {
+          default:
+            UNREACHABLE;
+          case ENTITY_SYSTEM_FRICTION:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-          if(ep->flags & ENTITY_FLAG_CONTINUOUS_TILE_COLLISION) {
+              ep->vel = Vector2Subtract(ep->vel, Vector2Scale(ep->vel, ep->friction*gp->dt));
 
-            Vector2 new_pos = ep->pos;
-            Vector2 delta = Vector2Subtract(new_pos, old_pos);
+            }
+            break;
+          case ENTITY_SYSTEM_DYNAMICS:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
+
+              Vector2 a_times_t = Vector2Scale(ep->accel, gp->dt);
+              ep->vel = Vector2Add(ep->vel, a_times_t);
+              ep->pos = Vector2Add(ep->pos, Vector2Add(Vector2Scale(ep->vel, gp->dt), Vector2Scale(a_times_t, 0.5*gp->dt)));
+
+            }
+            break;
+          case ENTITY_SYSTEM_SPINNING:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-            //Vector2 old_tile_pos = point_from_tile(tile_from_point(old_pos));
-            //Vector2 new_tile_pos = point_from_tile(tile_from_point(new_pos));
+              float turn = ep->spin_vel * gp->dt;
+              ep->look_angle += turn;
+              //ep->look_dir = Vector2Rotate(ep->look_dir, turn);
 
-            //Vector2 tile_offset = Vector2Subtract(new_tile_pos, old_tile_pos);
+            }
+            break;
+          case ENTITY_SYSTEM_CONTINUOUS_TILE_COLLISION:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
+
+              Vector2 old_pos = ep->prev_pos;
+
+              Vector2 new_pos = ep->pos;
+              Vector2 delta = Vector2Subtract(new_pos, old_pos);
+
+              //Vector2 old_tile_pos = point_from_tile(tile_from_point(old_pos));
+              //Vector2 new_tile_pos = point_from_tile(tile_from_point(new_pos));
+
+              //Vector2 tile_offset = Vector2Subtract(new_tile_pos, old_tile_pos);
+
+              s64 old_tile = tile_from_point(old_pos);
+              s64 new_tile = tile_from_point(new_pos);
+
+              s64 old_row = 0;
+              s64 old_col = 0;
+              s64 new_row = 0;
+              s64 new_col = 0;
+
+              row_col_from_tile(old_tile, &old_row, &old_col);
+              row_col_from_tile(new_tile, &new_row, &new_col);
+
+              s64 begin_row = Clamp(MIN(old_row, new_row) - 1, 0, TILE_ROWS);
+              s64 begin_col = Clamp(MIN(old_col, new_col) - 1, 0, TILE_COLS);
+              s64 end_row   = Clamp(MAX(old_row, new_row) + 1, 0, TILE_ROWS);
+              s64 end_col   = Clamp(MAX(old_col, new_col) + 1, 0, TILE_COLS);
+
+              u8 *tiles = gp->tiles;
+
+              float radius = ep->radius;
+
+              int collisions_count = 0;
+
+              for(s64 i = begin_row; i <= end_row; i++) {
+                for(s64 j = begin_col; j <= end_col; j++) {
+                  s64 tile = j + i * TILE_COLS;
+
+                  if((1ull<<tiles[tile]) & COLLIDABLE_TILE_MASK) {
+
+                    Vector2 tile_origin_point = point_from_tile(tile);
+                    tile_origin_point = Vector2SubtractValue(tile_origin_point, radius);
+                    float tile_grown_size = TILE_SIZE + TIMES2(radius);
+
+                    bool skip[4] = {
+                      (1ull<<tiles[j + (s64)Clamp(i-1, 0, TILE_ROWS)*TILE_COLS]) & COLLIDABLE_TILE_MASK,
+                      (1ull<<tiles[(s64)Clamp(j+1, 0, TILE_COLS) + i*TILE_COLS]) & COLLIDABLE_TILE_MASK,
+                      (1ull<<tiles[j + (s64)Clamp(i+1, 0, TILE_ROWS)*TILE_COLS]) & COLLIDABLE_TILE_MASK,
+                      (1ull<<tiles[(s64)Clamp(j-1, 0, TILE_COLS) + i*TILE_COLS]) & COLLIDABLE_TILE_MASK,
+                    };
+
+                    Vector2 tile_points[5] = {
+                      tile_origin_point,
+                      { tile_origin_point.x + tile_grown_size, tile_origin_point.y },
+                      { tile_origin_point.x + tile_grown_size, tile_origin_point.y + tile_grown_size },
+                      { tile_origin_point.x, tile_origin_point.y + tile_grown_size },
+                      tile_origin_point,
+                    };
+
+                    /*
+                     *
+                     *    0
+                     * 3     1
+                     *    2
+                     *
+                     */
+
+                    for(int segment_i = 0; segment_i < 4; segment_i++) {
+                      if(skip[segment_i]) continue;
+
+                      gp->collision_counts[COLLISION_COUNTER_TILE_SEGMENT_TESTS]++;
+
+                      Collision_manifold manifold = tile_segment_intersect(old_pos, new_pos, tile_points[segment_i], tile_points[segment_i+1]);
+
+                      if(manifold.collided) {
+                        if(Vector2DotProduct(delta, manifold.normal) < 0) {
+                          collisions_count++;
+
+                          if(ep->flags & ENTITY_FLAG_BOUNCE_OFF_TILES) {
+                            if(manifold.segment_is_horizontal) {
+                              ep->vel.y *= -1;
+                              ep->pos.y = manifold.contact.y;
+                            } else if(manifold.segment_is_vertical) {
+                              ep->vel.x *= -1;
+                              ep->pos.x = manifold.contact.x;
+                            } else { /* corner case... literally */
+                              UNREACHABLE;
+                            }
+                          } else {
+                            if(manifold.segment_is_horizontal) {
+                              ep->vel.y = 0;
+                              ep->pos.y = manifold.contact.y;
+                            } else if(manifold.segment_is_vertical) {
+                              ep->vel.x = 0;
+                              ep->pos.x = manifold.contact.x;
+                            } else { /* corner case... literally */
+                              UNREACHABLE;
+                            }
+                          }
+
+                          break;
+                        }
+                      }
 
-            s64 old_tile = tile_from_point(old_pos);
-            s64 new_tile = tile_from_point(new_pos);
+                    }
 
-            s64 old_row = 0;
-            s64 old_col = 0;
-            s64 new_row = 0;
-            s64 new_col = 0;
+                  }
 
-            row_col_from_tile(old_tile, &old_row, &old_col);
-            row_col_from_tile(new_tile, &new_row, &new_col);
+                }
 
-            s64 begin_row = Clamp(MIN(old_row, new_row) - 1, 0, TILE_ROWS);
-            s64 begin_col = Clamp(MIN(old_col, new_col) - 1, 0, TILE_COLS);
-            s64 end_row   = Clamp(MAX(old_row, new_row) + 1, 0, TILE_ROWS);
-            s64 end_col   = Clamp(MAX(old_col, new_col) + 1, 0, TILE_COLS);
+                if(collisions_count >= 4) {
+                  break;
+                }
+              }
 
-            u8 *tiles = gp->tiles;
+            }
+            break;
+          case ENTITY_SYSTEM_DISCRETE_TILE_COLLISION:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
+
+              s64 tile = tile_from_point(ep->pos);
+              if((1ull<<gp->tiles[tile]) & COLLIDABLE_TILE_MASK) {
+                if(ep->flags & ENTITY_FLAG_DIE_ON_TILE_COLLISION) {
+                  ep->flags |= ENTITY_FLAG_DIE_NOW;
+                }
+              }
 
-            float radius = ep->radius;
+            }
+            break;
+          case ENTITY_SYSTEM_FOLLOW_HOLDER:
+            /* after the holder moved and hit tiles, so what it holds doesn't trail a tick behind */
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-            int collisions_count = 0;
+              Entity *parent = entity_from_handle(gp, ep->parent_handle);
 
-            for(s64 i = begin_row; i <= end_row; i++) {
-              for(s64 j = begin_col; j <= end_col; j++) {
-                s64 tile = j + i * TILE_COLS;
+              ep->manual_sprite_origin = parent->pos;
+              Vector2 offset = Vector2Rotate(ep->being_held_offset, parent->look_angle);
+              ep->pos = Vector2Add(parent->pos, offset);
 
-                if((1ull<<tiles[tile]) & COLLIDABLE_TILE_MASK) {
+            }
+            break;
+          case ENTITY_SYSTEM_SHOOT_GUN:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-                  Vector2 tile_origin_point = point_from_tile(tile);
-                  tile_origin_point = Vector2SubtractValue(tile_origin_point, radius);
-                  float tile_grown_size = TILE_SIZE + TIMES2(radius);
+              if(gp->state != GAME_STATE_GAME_OVER) {
+                entity_shoot_gun(gp, ep);
+              }
 
-                  bool skip[4] = {
-                    (1ull<<tiles[j + (s64)Clamp(i-1, 0, TILE_ROWS)*TILE_COLS]) & COLLIDABLE_TILE_MASK,
-                    (1ull<<tiles[(s64)Clamp(j+1, 0, TILE_COLS) + i*TILE_COLS]) & COLLIDABLE_TILE_MASK,
-                    (1ull<<tiles[j + (s64)Clamp(i+1, 0, TILE_ROWS)*TILE_COLS]) & COLLIDABLE_TILE_MASK,
-                    (1ull<<tiles[(s64)Clamp(j-1, 0, TILE_COLS) + i*TILE_COLS]) & COLLIDABLE_TILE_MASK,
-                  };
+            }
+            break;
+          case ENTITY_SYSTEM_INTERACT:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-                  Vector2 tile_points[5] = {
-                    tile_origin_point,
-                    { tile_origin_point.x + tile_grown_size, tile_origin_point.y },
-                    { tile_origin_point.x + tile_grown_size, tile_origin_point.y + tile_grown_size },
-                    { tile_origin_point.x, tile_origin_point.y + tile_grown_size },
-                    tile_origin_point,
-                  };
+              ep->flags &= ~ENTITY_FLAG_INTERACT;
 
-                  /*
-                   *
-                   *    0
-                   * 3     1
-                   *    2
-                   *
-                   */
+              Slice(Entity_ptr) candidates = spatial_grid_query(gp, ep->pos, 0);
 
-                  for(int segment_i = 0; segment_i < 4; segment_i++) {
-                    if(skip[segment_i]) continue;
+              for(int i = 0; i < candidates.count; i++) {
+                Entity *interacting = candidates.d[i];
 
-                    Collision_manifold manifold = tile_segment_intersect(old_pos, new_pos, tile_points[segment_i], tile_points[segment_i+1]);
+                if(ep != interacting && interacting->live) {
 
-                    if(manifold.collided) {
-                      if(Vector2DotProduct(delta, manifold.normal) < 0) {
-                        collisions_count++;
+                  if(interacting->flags & ENTITY_FLAG_IS_INTERACTABLE) {
+                    bool is_interacting =
+                      CheckCollisionPointCircle(ep->pos, interacting->pos, interacting->interact_radius);
+                    if(is_interacting) {
 
-                        if(ep->flags & ENTITY_FLAG_BOUNCE_OFF_TILES) {
-                          if(manifold.segment_is_horizontal) {
-                            ep->vel.y *= -1;
-                            ep->pos.y = manifold.contact.y;
-                          } else if(manifold.segment_is_vertical) {
-                            ep->vel.x *= -1;
-                            ep->pos.x = manifold.contact.x;
-                          } else { /* corner case... literally */
-                            UNREACHABLE;
-                          }
-                        } else {
-                          if(manifold.segment_is_horizontal) {
-                            ep->vel.y = 0;
-                            ep->pos.y = manifold.contact.y;
-                          } else if(manifold.segment_is_vertical) {
-                            ep->vel.x = 0;
-                            ep->pos.x = manifold.contact.x;
-                          } else { /* corner case... literally */
-                            UNREACHABLE;
-                          }
-                        }
+                      interacting->interact_proc(gp, interacting, ep);
+                      break;
 
-                        break;
-                      }
                     }
-
                   }
 
                 }
 
               }
 
-              if(collisions_count >= 4) {
-                break;
-              }
             }
+            break;
+          case ENTITY_SYSTEM_APPLY_COLLISION:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-          }
-
-          if(ep->flags & ENTITY_FLAG_DISCRETE_TILE_COLLISION) {
-            s64 tile = tile_from_point(ep->pos);
-            if((1ull<<gp->tiles[tile]) & COLLIDABLE_TILE_MASK) {
-              if(ep->flags & ENTITY_FLAG_DIE_ON_TILE_COLLISION) {
-                ep->flags |= ENTITY_FLAG_DIE_NOW;
-              }
-            }
-          }
+              if(ep->flags & ENTITY_FLAG_DIE_ON_APPLY_COLLISION) {
+                /* this only ever hits one thing, so sweep it and take the first one in its path */
+                Vector2 sweep_center = Vector2Lerp(ep->prev_pos, ep->pos, 0.5f);
+                float sweep_radius = 0.5f*Vector2Distance(ep->prev_pos, ep->pos) + ep->radius;
 
-          if(ep->flags & ENTITY_FLAG_HAS_GUN) {
-            if(gp->state != GAME_STATE_GAME_OVER) {
-              entity_shoot_gun(gp, ep);
-            }
-          }
+                Slice(Entity_ptr) candidates = spatial_grid_query(gp, sweep_center, sweep_radius);
 
-          if(ep->flags & ENTITY_FLAG_INTERACT) {
+                Entity *hit = 0;
+                float hit_toi = 2.0f;
 
-            ep->flags &= ~ENTITY_FLAG_INTERACT;
+                for(int i = 0; i < candidates.count; i++) {
+                  Entity *colliding = candidates.d[i];
 
-            for(int i = 0; i < gp->entities_allocated; i++) {
-              Entity *interacting = &gp->entities[i];
+                  if(ep != colliding && colliding->live && entity_kind_in_mask(colliding->kind, ep->apply_collision_mask)) {
+                    float toi;
+                    if(entity_check_swept_collision(gp, ep, colliding, &toi) && toi < hit_toi) {
+                      hit = colliding;
+                      hit_toi = toi;
+                    }
+                  }
 
-              if(ep != interacting && interacting->live) {
+                }
 
-                if(interacting->flags & ENTITY_FLAG_IS_INTERACTABLE) {
-                  bool is_interacting =
-                    CheckCollisionPointCircle(ep->pos, interacting->pos, interacting->interact_radius);
-                  if(is_interacting) {
+                if(hit) {
+                  ep->applied_collision = 1;
+                  ep->pos = Vector2Lerp(ep->prev_pos, ep->pos, hit_toi);
+                  hit->received_collision = 1;
 
-                    interacting->interact_proc(gp, interacting, ep);
-                    break;
+                  if(ep->collide_proc) {
+                    ep->collide_proc(gp, ep, hit);
+                  }
 
+                  if(ep->flags & ENTITY_FLAG_APPLY_COLLISION_DAMAGE) {
+                    hit->received_damage += ep->damage_amount;
                   }
+
                 }
 
+                continue;
               }
 
-            }
-
-          }
+              Slice(Entity_ptr) candidates = spatial_grid_query(gp, ep->pos, ep->radius);
 
-          if(ep->flags & ENTITY_FLAG_APPLY_COLLISION) {
+              for(int i = 0; i < candidates.count; i++) {
+                Entity *colliding = candidates.d[i];
 
-            for(int i = 0; i < gp->entities_allocated; i++) {
-              Entity *colliding = &gp->entities[i];
+                if(ep != colliding && colliding->live) {
 
-              if(ep != colliding && colliding->live) {
+                  if(entity_kind_in_mask(colliding->kind, ep->apply_collision_mask)) {
+                    if(entity_check_collision(gp, ep, colliding)) {
+                      ep->applied_collision = 1;
+                      colliding->received_collision = 1;
 
-                if(entity_kind_in_mask(colliding->kind, ep->apply_collision_mask)) {
-                  if(entity_check_collision(gp, ep, colliding)) {
-                    applied_collision = 1;
-                    colliding->received_collision = 1;
+                      if(ep->collide_proc) {
+                        ep->collide_proc(gp, ep, colliding);
+                      }
 
-                    if(ep->collide_proc) {
-                      ep->collide_proc(gp, ep, colliding);
-                    }
+                      if(ep->flags & ENTITY_FLAG_APPLY_COLLISION_DAMAGE) {
+                        colliding->received_damage += ep->damage_amount;
+                      }
 
-                    if(ep->flags & ENTITY_FLAG_APPLY_COLLISION_DAMAGE) {
-                      colliding->received_damage += ep->damage_amount;
                     }
 
                   }
@@ -3729,212 +5724,197 @@ void game_update_and_draw(Game *gp) {
               }
 
             }
+            break;
+          case ENTITY_SYSTEM_DIE_IF_CHILD_LIST_EMPTY:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-          }
+              ASSERT(ep->child_list);
+              if(ep->child_list->count <= 0) {
+                ep->flags |= ENTITY_FLAG_DIE_NOW;
+              }
 
-          if(ep->flags & ENTITY_FLAG_DIE_IF_CHILD_LIST_EMPTY) {
-            ASSERT(ep->child_list);
-            if(ep->child_list->count <= 0) {
-              ep->flags |= ENTITY_FLAG_DIE_NOW;
             }
-          }
+            break;
+          case ENTITY_SYSTEM_DIE_ON_APPLY_COLLISION:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
+
+              if(ep->applied_collision) {
+                ep->flags |= ENTITY_FLAG_DIE_NOW;
+              }
 
-          if(ep->flags & ENTITY_FLAG_DIE_ON_APPLY_COLLISION) {
-            if(applied_collision) {
-              ep->flags |= ENTITY_FLAG_DIE_NOW;
             }
-          }
+            break;
+          case ENTITY_SYSTEM_EFFECT_TINT:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
+
+              if(ep->effect_tint_timer < 0) {
+                ep->effect_tint_timer = 0;
+                ep->flags &= ~ENTITY_FLAG_APPLY_EFFECT_TINT;
+              } else {
+                ep->effect_tint_timer -= ep->effect_tint_timer_vel*gp->dt;
+              }
 
-          if(ep->flags & ENTITY_FLAG_APPLY_EFFECT_TINT) {
-            if(ep->effect_tint_timer < 0) {
-              ep->effect_tint_timer = 0;
-              ep->flags &= ~ENTITY_FLAG_APPLY_EFFECT_TINT;
-            } else {
-              ep->effect_tint_timer -= ep->effect_tint_timer_vel*gp->dt;
             }
-          }
+            break;
+          case ENTITY_SYSTEM_RECEIVE_COLLISION:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-          if(ep->flags & ENTITY_FLAG_RECEIVE_COLLISION) {
-            if(!is_fully_on_screen) {
-              ep->received_collision = 0;
-              ep->received_damage = 0;
-            } else {
-              if(ep->received_collision) {
+              if(!ep->fully_on_screen) {
                 ep->received_collision = 0;
+                ep->received_damage = 0;
+              } else {
+                if(ep->received_collision) {
+                  ep->received_collision = 0;
 
-                if(ep->flags & ENTITY_FLAG_RECEIVE_COLLISION_DAMAGE) {
+                  if(ep->flags & ENTITY_FLAG_RECEIVE_COLLISION_DAMAGE) {
 
-                  if(ep->received_damage > 0) {
-                    if(IsSoundValid(ep->hurt_sound)) {
-                      SetSoundPan(ep->hurt_sound, Normalize(ep->pos.x, WINDOW_WIDTH, 0));
-                      if(ep->kind == ENTITY_KIND_PLAYER) {
-                        SetSoundVolume(ep->hurt_sound, 0.17f);
-                      } else {
-                        SetSoundVolume(ep->hurt_sound, 0.5f);
+                    if(ep->received_damage > 0) {
+                      Sound hurt_sound = entity_cold(gp, ep)->hurt_sound;
+                      if(IsSoundValid(hurt_sound)) {
+                        SetSoundPan(hurt_sound, Normalize(ep->pos.x, WINDOW_WIDTH, 0));
+                        if(ep->kind == ENTITY_KIND_PLAYER) {
+                          SetSoundVolume(hurt_sound, 0.17f);
+                        } else {
+                          SetSoundVolume(hurt_sound, 0.5f);
+                        }
+                        PlaySound(hurt_sound);
                       }
-                      PlaySound(ep->hurt_sound);
                     }
-                  }
 
-                  ep->health -= ep->received_damage;
+                    ep->health -= ep->received_damage;
 
-                  if(ep->flags & ENTITY_FLAG_DAMAGE_INCREMENTS_SCORE) {
-                    gp->score += ep->received_damage;
-                  }
+                    if(ep->flags & ENTITY_FLAG_DAMAGE_INCREMENTS_SCORE) {
+                      gp->score += ep->received_damage;
+                    }
 
-                  ep->received_damage = 0;
+                    ep->received_damage = 0;
 
-                  if(ep->kind != ENTITY_KIND_PLAYER) {
-                    ep->flags |= ENTITY_FLAG_APPLY_EFFECT_TINT;
+                    if(ep->kind != ENTITY_KIND_PLAYER) {
+                      ep->flags |= ENTITY_FLAG_APPLY_EFFECT_TINT;
 
-                    ep->effect_tint = BLOOD;
+                      ep->effect_tint = BLOOD;
 
-                    if(ep->effect_tint_duration == 0) {
-                      ep->effect_tint_duration = 0.02f;
-                    }
-                    if(ep->effect_tint_timer_vel == 0) {
-                      ep->effect_tint_timer_vel = 1.0f;
+                      if(ep->effect_tint_duration == 0) {
+                        ep->effect_tint_duration = 0.02f;
+                      }
+                      if(ep->effect_tint_timer_vel == 0) {
+                        ep->effect_tint_timer_vel = 1.0f;
+                      }
+
+                      ep->effect_tint_timer = ep->effect_tint_duration;
                     }
 
-                    ep->effect_tint_timer = ep->effect_tint_duration;
-                  }
+                    if(ep->health <= 0) {
+                      ep->flags |= ENTITY_FLAG_DIE_NOW;
+                    }
 
-                  if(ep->health <= 0) {
-                    ep->flags |= ENTITY_FLAG_DIE_NOW;
                   }
 
                 }
-
               }
-            }
-          }
-
-          if(ep->flags & ENTITY_FLAG_HAS_SPRITE) {
-            sprite_update(gp, ep);
-          }
 
-          if(ep->flags & ENTITY_FLAG_NOT_ON_SCREEN) {
-            if(is_on_screen) {
-              ep->flags ^= ENTITY_FLAG_NOT_ON_SCREEN | ENTITY_FLAG_ON_SCREEN;
             }
-          }
+            break;
+          case ENTITY_SYSTEM_SPRITE:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-          if(ep->flags & ENTITY_FLAG_HAS_LIFETIME) {
-            ASSERT(ep->life_time_duration > 0);
+              sprite_update(gp, ep);
 
-            if(ep->life_timer >= ep->life_time_duration) {
-              ep->life_timer = 0;
-              ep->flags |= ENTITY_FLAG_DIE_NOW;
-            } else {
-              ep->life_timer += gp->dt;
             }
+            break;
+          case ENTITY_SYSTEM_ENTER_SCREEN:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-          }
+              if(ep->on_screen) {
+                ep->flags ^= ENTITY_FLAG_NOT_ON_SCREEN | ENTITY_FLAG_ON_SCREEN;
+              }
 
-          if(ep->flags & ENTITY_FLAG_EMIT_SPAWN_PARTICLES) {
-            ep->flags &= ~ENTITY_FLAG_EMIT_SPAWN_PARTICLES;
+            }
+            break;
+          case ENTITY_SYSTEM_LIFETIME:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-            if(is_on_screen) {
+              ASSERT(ep->life_time_duration > 0);
 
-              //if(IsSoundValid(ep->spawn_sound)) {
-              //  PlaySound(ep->spawn_sound);
-              //}
+              if(ep->life_timer >= ep->life_time_duration) {
+                ep->life_timer = 0;
+                ep->flags |= ENTITY_FLAG_DIE_NOW;
+              } else {
+                ep->life_timer += gp->dt;
+              }
 
-              Particle_emitter tmp = ep->particle_emitter;
-              ep->particle_emitter = ep->spawn_particle_emitter;
-              entity_emit_particles(gp, ep);
-              ep->particle_emitter = tmp;
             }
+            break;
+          case ENTITY_SYSTEM_SPAWN_PARTICLES:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
 
-          }
+              ep->flags &= ~ENTITY_FLAG_EMIT_SPAWN_PARTICLES;
 
-          if(ep->flags & ENTITY_FLAG_DIE_NOW) {
+              if(ep->on_screen) {
+
+                //if(IsSoundValid(ep->spawn_sound)) {
+                //  PlaySound(ep->spawn_sound);
+                //}
 
-            if(is_on_screen) {
-              if(ep->flags & ENTITY_FLAG_EMIT_DEATH_PARTICLES) {
                 Particle_emitter tmp = ep->particle_emitter;
-                ep->particle_emitter = ep->death_particle_emitter;
+                ep->particle_emitter = ep->spawn_particle_emitter;
                 entity_emit_particles(gp, ep);
                 ep->particle_emitter = tmp;
               }
 
             }
+            break;
+          case ENTITY_SYSTEM_DIE:
+            for(s64 i = 0; i < batch.count; i++) {
+              Entity *ep = batch.d[i];
+
+              if(ep->on_screen) {
+                if(ep->flags & ENTITY_FLAG_EMIT_DEATH_PARTICLES) {
+                  Particle_emitter tmp = ep->particle_emitter;
+                  ep->particle_emitter = ep->death_particle_emitter;
+                  entity_emit_particles(gp, ep);
+                  ep->particle_emitter = tmp;
+                }
 
-            entity_die(gp, ep);
-            goto entity_update_end;
-          }
-
-entity_update_end:;
-        } /* entity_update */
-
-      } /* update_entities */
-
-    }
-
-    gp->live_particles = 0;
-
-    for(int i = 0; i < MAX_PARTICLES; i++) {
-      Particle *p = &gp->particles[i];
-
-      if(p->live >= p->lifetime) {
-        p->live = 0;
-        p->lifetime = 0;
-        continue;
-      }
-
-      gp->live_particles++;
-
-      { /* particle_update */
-
-        if(!CheckCollisionCircleRec(p->pos, p->radius, WINDOW_RECT)) {
-          p->live = 0;
-          p->lifetime = 0;
-          gp->live_particles--;
-          continue;
-        }
+              }
 
-        p->pos = Vector2Add(p->pos, Vector2Scale(p->vel, gp->dt));
-        p->vel = Vector2Subtract(p->vel, Vector2Scale(p->vel, p->friction*gp->dt));
+              entity_die(gp, ep);
 
-        if(p->radius > 0) {
-          p->radius -= p->shrink * gp->dt;
+            }
+            break;
         }
 
-        p->live += gp->dt;
-
-      } /* particle_update */
+      } /* systems */
 
     }
 
+    PROF_ZONE("particles") particles_update(gp);
+
 update_end:;
+    prof_zone_end();
+    gp->state = gp->next_state;
+    gp->input_flags &= INPUT_FLAG_HELD;
   } /* update */
 
-  defer_loop(BeginDrawing(), EndDrawing())
-  { /* draw to screen */
-    ClearBackground(BLACK);
-
-    gp->cam.offset =
-      (Vector2) {
-        (float)GetScreenWidth()*0.5f,
-        (float)GetScreenHeight()*0.5f,
-      };
-
-    if(!(gp->debug_flags & GAME_DEBUG_FLAG_FREE_CAM)) {
-
-      if(gp->player) {
-        gp->cam.target = gp->player->pos;
-
-        if(gp->flags & GAME_FLAG_CAMERA_SHAKE) {
-          gp->cam.target = Vector2Add(gp->cam.target, gp->cam_shake.offset);
-        }
+  /* too far behind to catch up, drop the backlog rather than run even more ticks next frame */
+  gp->sim_accumulator = MIN(gp->sim_accumulator, SIM_DT);
+  gp->sim_alpha = (f32)(gp->sim_accumulator / SIM_DT);
 
-        if(gp->flags & GAME_FLAG_CAMERA_PULSATE) {
-          gp->cam.zoom = gp->cam_pulsate.save_zoom - gp->cam_pulsate.zoom_offset; 
-        }
+}
 
-      }
+void game_draw(Game *gp) {
 
-    }
+  defer_loop(BeginDrawing(), EndDrawing())
+  { /* draw to screen */
+    ClearBackground(BLACK);
 
     if(gp->flags & GAME_FLAG_DRAW_IN_CAMERA) defer_loop(BeginMode2D(gp->cam), EndMode2D())
     { /* draw in camera */
@@ -3959,61 +5939,7 @@ update_end:;
         tiles = gp->editor.tiles;
       }
 
-      for(s64 i = 0; i < TILES_COUNT; i++) {
-        switch(tiles[i]) {
-          case TILE_KIND_WALL:
-            {
-              Vector2 tile_point = point_from_tile(i);
-
-              {
-                Rectangle rec =
-                {
-                  .x = tile_point.x,
-                  .y = tile_point.y,
-                  .width = TILE_SIZE,
-                  .height = TILE_SIZE,
-                };
-
-                DrawRectangleRec(rec, SKYBLUE);
-              }
-
-            } break;
-          case TILE_KIND_FLOOR:
-            {
-              Vector2 tile_point = point_from_tile(i);
-
-              {
-                Rectangle rec =
-                {
-                  .x = tile_point.x,
-                  .y = tile_point.y,
-                  .width = TILE_SIZE,
-                  .height = TILE_SIZE,
-                };
-
-                DrawRectangleRec(rec, GRAY);
-              }
-
-            } break;
-          case TILE_KIND_RED_DOOR:
-            {
-              Vector2 tile_point = point_from_tile(i);
-
-              {
-                Rectangle rec =
-                {
-                  .x = tile_point.x,
-                  .y = tile_point.y,
-                  .width = TILE_SIZE,
-                  .height = TILE_SIZE,
-                };
-
-                DrawRectangleRec(rec, RED);
-              }
-
-            } break;
-        }
-      }
+      PROF_ZONE("tile draw") tile_chunks_draw(gp, tiles);
 
 
       if(gp->debug_flags & GAME_DEBUG_FLAG_EDITOR) {
@@ -4050,13 +5976,24 @@ update_end:;
 
       }
 
+      PROF_ZONE("entity draw")
       for(Entity_order order = ENTITY_ORDER_FIRST; order < ENTITY_ORDER_MAX; order++) {
-        for(int i = 0; i < gp->entities_allocated; i++)
+        Slice(Entity_ptr) draw_list = gp->draw_lists[order];
+
+        for(s64 i = 0; i < draw_list.count; i++)
         { /* entity_draw */
 
-          Entity *ep = &gp->entities[i];
+          Entity *ep = draw_list.d[i];
 
-          if(!ep->live || ep->draw_order != order) continue;
+          Vector2 draw_pos = entity_draw_pos(gp, ep);
+
+          if(!CheckCollisionCircleRec(draw_pos, entity_draw_radius(ep), gp->cam_view_rect)) continue;
+
+          /* everything below draws from the entity, so it is moved to where it is drawn and put back after */
+          Vector2 pos = ep->pos;
+          f32 sprite_rotation = ep->sprite_rotation;
+          ep->pos = draw_pos;
+          ep->sprite_rotation += (entity_draw_look_angle(gp, ep) - ep->look_angle) * RAD2DEG;
 
           if(ep->flags & ENTITY_FLAG_FILL_BOUNDS) {
             Color tint = ep->fill_color;
@@ -4064,12 +6001,8 @@ update_end:;
           }
 
           if(ep->flags & ENTITY_FLAG_HAS_SPRITE) {
-            Vector2 pos = ep->pos;
-
             // TODO sprite offset
             draw_sprite(gp, ep);
-
-            ep->pos = pos;
           }
 
           if(gp->debug_flags & GAME_DEBUG_FLAG_DRAW_ALL_ENTITY_BOUNDS) {
@@ -4090,25 +6023,15 @@ update_end:;
             }
           }
 
+          ep->pos = pos;
+          ep->sprite_rotation = sprite_rotation;
+
         } /* entity_draw */
       }
 
-      for(int i = 0; i < MAX_PARTICLES; i++) {
-        Particle *p = &gp->particles[i];
-
-        if(p->live >= p->lifetime) continue;
-
-        { /* particle_draw */
-
-          Rectangle rec = { p->pos.x - p->radius, p->pos.y - p->radius, TIMES2(p->radius), TIMES2(p->radius) };
+      PROF_ZONE("projectile draw") projectiles_draw(gp);
 
-          Color tint = ColorLerp(p->begin_tint, p->end_tint, Normalize(p->live, 0, p->lifetime));
-
-          DrawRectangleRec(rec, tint);
-
-        } /* particle_draw */
-
-      }
+      PROF_ZONE("particle draw") particles_draw(gp);
 
     } /* draw in camera */
 
@@ -4165,66 +6088,22 @@ update_end:;
         hint_on = !hint_on;
         hint_blink_time = 0;
       } else {
-        hint_blink_time += gp->dt;
+        hint_blink_time += gp->frame_dt;
       }
 
     }
 
 
 #ifdef DEBUG
-    if(gp->debug_flags & GAME_DEBUG_FLAG_DEBUG_UI) { /* debug overlay */
-      char *debug_text = frame_push_array(char, 256);
-      char *debug_text_fmt =
-        "sound: %s\n"
-        "player_is_invincible: %s\n"
-        "frame time: %.7f\n"
-        "live entities count: %i\n"
-        "live enemies count: %i\n"
-        "live particles count: %i\n"
-        "most entities allocated: %li\n"
-        "particle_pos: %i\n"
-        "screen width: %i\n"
-        "screen height: %i\n"
-        "render width: %i\n"
-        "render height: %i\n"
-        "player pos: { x = %.1f, y = %.1f }\n"
-        "level: %i\n"
-        "phase: %i\n"
-        "editor tool[%i]: %s\n"
-        "game state: %s";
-      stbsp_sprintf(debug_text,
-          debug_text_fmt,
-          (gp->debug_flags & GAME_DEBUG_FLAG_MUTE) ? "off" : "on",
-          (gp->debug_flags & GAME_DEBUG_FLAG_PLAYER_INVINCIBLE) ? "on" : "off",
-          gp->dt,
-          gp->live_entities,
-          gp->live_enemies,
-          gp->live_particles,
-          gp->entities_allocated,
-          gp->particles_pos,
-          GetScreenWidth(),
-          GetScreenHeight(),
-          GetRenderWidth(),
-          GetRenderHeight(),
-          gp->player ? gp->player->pos.x : 0,
-          gp->player ? gp->player->pos.y : 0,
-          gp->level+1,
-          gp->phase_index+1,
-          (int)(gp->editor.tool),
-          Editor_tool_strings[gp->editor.tool],
-          Game_state_strings[gp->state]);
-      Vector2 debug_text_size = MeasureTextEx(gp->font, debug_text, 20, 1.0);
-      DrawText(debug_text, 10, GetScreenHeight() - debug_text_size.y - 10, 20, GREEN);
-    } /* debug overlay */
+    if(gp->debug_flags & GAME_DEBUG_FLAG_DEBUG_UI) {
+      debug_window(gp);
+    }
 #endif
 
   } /* draw to screen */
 
-
-  gp->state = gp->next_state;
-
-  gp->frame_index++;
-
-  arena_clear(gp->frame_arena);
-
 }
+
+/* last, microui.c defines short macros like push and expect that would leak into the game */
+#include "third_party/microui/microui.c"
+#include "third_party/microui/murl.c"
@@ -14,6 +14,9 @@
 
 #define SOUND_DATA_PATH "./sounds/"
 
+#define PARTICLE_EMITTERS_PATH "./particle_emitters.json"
+#define PARTICLE_DATA_PATH "particle_data.c"
+
 
 typedef struct File_frame_range {
   Str8 file_title;
@@ -30,6 +33,7 @@ void print_json_(Arena *a, JSON_value *val, int indent);
 void print_json(JSON_value *val);
 
 Color color_from_hexcode(Str8 hexcode);
+b32   json_number_range(JSON_value *val, f64 *min, f64 *max);
 
 
 Arena *scratch;
@@ -90,6 +94,24 @@ Color color_from_hexcode(Str8 hexcode) {
   return result;
 }
 
+b32 json_number_range(JSON_value *val, f64 *min, f64 *max) {
+  if(val->kind != JSON_VALUE_KIND_ARRAY || val->array_length != 2) {
+    return 0;
+  }
+
+  JSON_value *a = val->value;
+  JSON_value *b = a->next;
+
+  if(a->kind != JSON_VALUE_KIND_NUMBER || b->kind != JSON_VALUE_KIND_NUMBER) {
+    return 0;
+  }
+
+  *min = a->floating;
+  *max = b->floating;
+
+  return *min <= *max;
+}
+
 int main(void) {
 
   //SetTraceLogLevel(LOG_NONE);
@@ -98,6 +120,173 @@ int main(void) {
 
   JSON_parser json_parser;
 
+  { /* generate particle emitters */
+
+    /* NOTE
+     *
+     * particle_emitters.json is an object mapping PARTICLE_EMITTERS names to arrays of bursts,
+     * an emitter spawns every one of its bursts. Each burst is an object with the fields
+     *
+     *   count            [min, max] particles spawned
+     *   lifetime_frames  [min, max] lifetime in frames at TARGET_FPS
+     *   aim              "up" or "against_vel", the direction the spread is centered on
+     *   spread           half angle of the spread as a fraction of PI, 1 is all around
+     *   speed            [min, max]
+     *   radius           [min, max]
+     *   shrink           fraction of the starting radius lost over the lifetime (optional)
+     *   shrink_rate      constant shrink in units per second (optional)
+     *   friction         [min, max]
+     *   begin_tint       "#rrggbb[aa]"
+     *   end_tint         "#rrggbb[aa]"
+     *
+     * All ranges are sampled uniformly per particle by emit_particles.
+     */
+
+    TraceLog(LOG_INFO, "generating particle emitters");
+
+    s64 particle_src_len = 0;
+    u8 *particle_src = LoadFileData(PARTICLE_EMITTERS_PATH, (int*)&particle_src_len);
+
+    if(!particle_src) {
+      TraceLog(LOG_ERROR, "could not load "PARTICLE_EMITTERS_PATH);
+      return 1;
+    }
+
+    json_init_parser(&json_parser, context_scratch_arena, particle_src, particle_src_len);
+    JSON_value *root = json_parse(&json_parser);
+
+    if(!root || json_parser.err) {
+      TraceLog(LOG_ERROR, "error in parsing "PARTICLE_EMITTERS_PATH);
+      return 1;
+    }
+
+    Str8 bursts_code = {0};
+    Str8 emitters_code = {0};
+    s64 bursts_count = 0;
+
+    for(JSON_value *emitter = root->value; emitter; emitter = emitter->next) {
+
+      if(!str8_is_cident(emitter->name)) {
+        TraceLog(LOG_ERROR, "particle emitter '%.*s' has an invalid name, it must match one of the PARTICLE_EMITTERS", (int)emitter->name.len, emitter->name.s);
+        return 1;
+      }
+
+      if(emitter->kind != JSON_VALUE_KIND_ARRAY) {
+        TraceLog(LOG_ERROR, "particle emitter '%.*s' must be an array of bursts", (int)emitter->name.len, emitter->name.s);
+        return 1;
+      }
+
+      s64 first_burst = bursts_count;
+
+      for(JSON_value *burst = emitter->value; burst; burst = burst->next) {
+        ASSERT(burst->kind == JSON_VALUE_KIND_OBJECT);
+
+        f64 count[2] = {0}, lifetime[2] = {0}, speed[2] = {0}, radius[2] = {0}, friction[2] = {0};
+        f64 spread = 0, shrink = 0, shrink_rate = 0;
+        b32 aim_against_vel = 0;
+        Color begin_tint = WHITE, end_tint = WHITE;
+
+        for(JSON_value *field = burst->value; field; field = field->next) {
+          b32 ok = 1;
+
+          if(str8_match_lit("count", field->name)) {
+            ok = json_number_range(field, &count[0], &count[1]);
+          } else if(str8_match_lit("lifetime_frames", field->name)) {
+            ok = json_number_range(field, &lifetime[0], &lifetime[1]);
+          } else if(str8_match_lit("speed", field->name)) {
+            ok = json_number_range(field, &speed[0], &speed[1]);
+          } else if(str8_match_lit("radius", field->name)) {
+            ok = json_number_range(field, &radius[0], &radius[1]);
+          } else if(str8_match_lit("friction", field->name)) {
+            ok = json_number_range(field, &friction[0], &friction[1]);
+          } else if(str8_match_lit("spread", field->name)) {
+            ok = field->kind == JSON_VALUE_KIND_NUMBER;
+            spread = field->floating;
+          } else if(str8_match_lit("shrink", field->name)) {
+            ok = field->kind == JSON_VALUE_KIND_NUMBER;
+            shrink = field->floating;
+          } else if(str8_match_lit("shrink_rate", field->name)) {
+            ok = field->kind == JSON_VALUE_KIND_NUMBER;
+            shrink_rate = field->floating;
+          } else if(str8_match_lit("aim", field->name)) {
+            ok = field->kind == JSON_VALUE_KIND_STRING && (str8_match_lit("up", field->str) || str8_match_lit("against_vel", field->str));
+            aim_against_vel = str8_match_lit("against_vel", field->str);
+          } else if(str8_match_lit("begin_tint", field->name)) {
+            ok = field->kind == JSON_VALUE_KIND_STRING;
+            begin_tint = color_from_hexcode(field->str);
+          } else if(str8_match_lit("end_tint", field->name)) {
+            ok = field->kind == JSON_VALUE_KIND_STRING;
+            end_tint = color_from_hexcode(field->str);
+          } else {
+            TraceLog(LOG_WARNING, "particle emitter '%.*s' has an unrecognized field '%.*s'",
+                (int)emitter->name.len, emitter->name.s, (int)field->name.len, field->name.s);
+          }
+
+          if(!ok) {
+            TraceLog(LOG_ERROR, "particle emitter '%.*s' has an invalid value for '%.*s'",
+                (int)emitter->name.len, emitter->name.s, (int)field->name.len, field->name.s);
+            return 1;
+          }
+
+        }
+
+        if(lifetime[0] <= 0) {
+          TraceLog(LOG_ERROR, "particle emitter '%.*s' has a burst with no lifetime", (int)emitter->name.len, emitter->name.s);
+          return 1;
+        }
+
+        bursts_code =
+          scratch_push_str8f(
+              "%S  [%li] = {\n"
+              "    .count_min = %i, .count_max = %i,\n"
+              "    .lifetime_min = TARGET_FRAME_TIME * %ff, .lifetime_max = TARGET_FRAME_TIME * %ff,\n"
+              "    .speed_min = %ff, .speed_max = %ff,\n"
+              "    .radius_min = %ff, .radius_max = %ff,\n"
+              "    .friction_min = %ff, .friction_max = %ff,\n"
+              "    .spread = PI * %ff, .aim_against_vel = %i,\n"
+              "    .shrink = %ff, .shrink_rate = %ff,\n"
+              "    .begin_tint = { %u, %u, %u, %u }, .end_tint = { %u, %u, %u, %u },\n"
+              "  },\n",
+              bursts_code, bursts_count,
+              (int)count[0], (int)count[1],
+              lifetime[0], lifetime[1],
+              speed[0], speed[1],
+              radius[0], radius[1],
+              friction[0], friction[1],
+              spread, aim_against_vel,
+              shrink, shrink_rate,
+              begin_tint.r, begin_tint.g, begin_tint.b, begin_tint.a,
+              end_tint.r, end_tint.g, end_tint.b, end_tint.a);
+
+        bursts_count++;
+      }
+
+      emitters_code =
+        scratch_push_str8f(
+            "%S  [PARTICLE_EMITTER_%S] = { .first_burst = %li, .bursts_count = %li },\n",
+            emitters_code, emitter->name, first_burst, bursts_count - first_burst);
+
+    }
+
+    Str8 code =
+      scratch_push_str8f(
+          "\n/////////////////////////\n"
+          "/// BEGIN GENERATED\n\n"
+          "/* particle bursts */\n\n"
+          "const Particle_burst __particle_bursts[%li] =\n{\n%S};\n\n"
+          "/* particle emitters */\n\n"
+          "const Particle_emitter_def __particle_emitters[PARTICLE_EMITTER_MAX] =\n{\n%S};\n"
+          "\n\n/////////////////////////\n"
+          "/// END GENERATED\n\n",
+          bursts_count, bursts_code, emitters_code);
+
+    SaveFileData(PARTICLE_DATA_PATH, code.s, code.len);
+
+    UnloadFileData(particle_src);
+    scratch_clear();
+
+  } /* generate particle emitters */
+
   TraceLog(LOG_INFO, "generating sprite atlas png and metadata");
   
   // TODO steal comand execution code from nob.h
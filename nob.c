@@ -85,9 +85,11 @@ char vscode_settings[] =
 #define CC "clang"
 #define DEV_FLAGS "-g", "-O0", "-Wall", "-Wpedantic", "-Werror", "-Wno-switch", "-Wno-comment", "-Wno-format-pedantic", "-Wno-initializer-overrides", "-Wno-extra-semi", "-D_UNITY_BUILD_", "-DDEBUG"
 #define RELEASE_FLAGS "-O2", "-Wall", "-Wpedantic", "-Werror", "-Wno-switch", "-Wno-comment", "-Wno-format-pedantic", "-Wno-initializer-overrides", "-Wno-extra-semi", "-D_UNITY_BUILD_"
-#define WASM_FLAGS "-Os", "-O2", "-Wall", "-Wpedantic", "-Werror", "-Wno-switch", "-Wno-comment", "-Wno-format-pedantic", "-Wno-initializer-overrides", "-Wno-extra-semi", "-Wno-pthreads-mem-growth", "-D_UNITY_BUILD_"
+#define HEADLESS_FLAGS "-O2", "-Wall", "-Wpedantic", "-Werror", "-Wno-switch", "-Wno-comment", "-Wno-format-pedantic", "-Wno-initializer-overrides", "-Wno-extra-semi", "-D_UNITY_BUILD_", "-DDEBUG", "-I./third_party/raylib/"
+#define WASM_FLAGS "-Os", "-O2", "-msimd128", "-Wall", "-Wpedantic", "-Werror", "-Wno-switch", "-Wno-comment", "-Wno-format-pedantic", "-Wno-initializer-overrides", "-Wno-extra-semi", "-Wno-pthreads-mem-growth", "-D_UNITY_BUILD_"
 #define TARGET "jurassic.c"
 #define EXE "jurassic"
+#define HEADLESS_EXE "jurassic_headless"
 #define LDFLAGS "-lraylib", "-lm", "-lpthread"
 
 #if defined(OS_WINDOWS)
@@ -343,6 +345,8 @@ int build_hot_reload(void);
 int build_hot_reload_cradle(void);
 int build_hot_reload_no_cradle(void);
 int build_release(void);
+int build_headless(void);
+int run_bench(void);
 int build_wasm(void);
 int build_itch(void);
 int run_tags(void);
@@ -617,6 +621,35 @@ int build_release(void) {
   return 1;
 }
 
+/* no raylib to link, headless_cradle.c brings its own null backend */
+int build_headless(void) {
+  Nob_Cmd cmd = {0};
+
+  nob_log(NOB_INFO, "building headless");
+
+  ASSERT(nob_mkdir_if_not_exists("build"));
+  ASSERT(nob_mkdir_if_not_exists("./build/headless"));
+
+  nob_cmd_append(&cmd, CC, HEADLESS_FLAGS, "headless_cradle.c", "-o", "./build/headless/"HEADLESS_EXE, "-lm");
+  if(!nob_cmd_run_sync_and_reset(&cmd)) return 0;
+
+  return 1;
+}
+
+/* every stress scenario at its default count, diff the output between commits to catch regressions */
+int run_bench(void) {
+  Nob_Cmd cmd = {0};
+
+  if(!build_headless()) return 0;
+
+  nob_log(NOB_INFO, "running benchmark scenarios");
+
+  nob_cmd_append(&cmd, "./build/headless/"HEADLESS_EXE, "-scenario", "all");
+  if(!nob_cmd_run_sync_and_reset(&cmd)) return 0;
+
+  return 1;
+}
+
 int build_wasm(void) {
   Nob_Cmd cmd = {0};
 
@@ -775,6 +808,8 @@ int main(int argc, char **argv) {
   run_tags();
 
   //if(!build_release()) return 1;
+  //if(!build_headless()) return 1;
+  //if(!run_bench()) return 1;
   //if(!build_wasm()) return 1;
   //if(!build_itch()) return 1;
   if(!build_hot_reload_no_cradle()) return 1;
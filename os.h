@@ -13,6 +13,13 @@
 void* os_alloc(u64 size);
 void  os_free(void *ptr);
 
+// reserve address space with no memory behind it, then commit pages of it
+// before touching them, sizes and pointers are page aligned
+void* os_reserve(u64 size);
+b32   os_commit(void *ptr, u64 size);
+void  os_decommit(void *ptr, u64 size);
+void  os_release(void *ptr, u64 size);
+
 Str8 os_get_current_dir(void);
 b32 os_set_current_dir(Str8 dir_path);
 b32 os_set_current_dir_cstr(char *dir_path_cstr);
@@ -34,6 +41,7 @@ b32 os_remove_file(Str8 path);
 
 #include <limits.h>
 #include <unistd.h>
+#include <sys/mman.h>
 
 #define OS_PATH_LEN PATH_MAX
 
@@ -49,6 +57,7 @@ b32 os_remove_file(Str8 path);
 #include <limits.h>
 #include <unistd.h>
 #include <sys/param.h>
+#include <sys/mman.h>
 
 #define OS_PATH_LEN MAXPATHLEN
 
@@ -79,6 +88,41 @@ void os_free(void *ptr) {
   free(ptr);
 }
 
+#if defined(OS_LINUX) || defined(OS_MAC)
+
+void* os_reserve(u64 size) {
+  void *result = mmap(0, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if(result == MAP_FAILED) {
+    result = 0;
+  }
+  return result;
+}
+
+b32 os_commit(void *ptr, u64 size) {
+  b32 result = !mprotect(ptr, size, PROT_READ | PROT_WRITE);
+  return result;
+}
+
+void os_decommit(void *ptr, u64 size) {
+  /* drop the pages first so touching them again faults in zeroed memory */
+  madvise(ptr, size, MADV_DONTNEED);
+  mprotect(ptr, size, PROT_NONE);
+}
+
+void os_release(void *ptr, u64 size) {
+  munmap(ptr, size);
+}
+
+#else
+
+/* emscripten's mmap hands out real memory, there is nothing to reserve */
+void* os_reserve(u64 size) { return 0; }
+b32   os_commit(void *ptr, u64 size) { return 0; }
+void  os_decommit(void *ptr, u64 size) {}
+void  os_release(void *ptr, u64 size) {}
+
+#endif
+
 
 Str8 os_get_current_dir(void) {
   size_t buf_size = OS_PATH_LEN;
@@ -0,0 +1,139 @@
+
+/////////////////////////
+/// BEGIN GENERATED
+
+/* particle bursts */
+
+const Particle_burst __particle_bursts[11] =
+{
+  [0] = {
+    .count_min = 2, .count_max = 10,
+    .lifetime_min = TARGET_FRAME_TIME * 17.000000f, .lifetime_max = TARGET_FRAME_TIME * 20.000000f,
+    .speed_min = 600.000000f, .speed_max = 900.000000f,
+    .radius_min = 0.300000f, .radius_max = 0.700000f,
+    .friction_min = 0.000000f, .friction_max = 5.000000f,
+    .spread = PI * 0.400000f, .aim_against_vel = 1,
+    .shrink = 1.100000f, .shrink_rate = 0.000000f,
+    .begin_tint = { 255, 188, 3, 255 }, .end_tint = { 255, 188, 3, 211 },
+  },
+  [1] = {
+    .count_min = 50, .count_max = 60,
+    .lifetime_min = TARGET_FRAME_TIME * 10.000000f, .lifetime_max = TARGET_FRAME_TIME * 20.000000f,
+    .speed_min = 1500.000000f, .speed_max = 1800.000000f,
+    .radius_min = 1.600000f, .radius_max = 2.200000f,
+    .friction_min = 0.000000f, .friction_max = 20.000000f,
+    .spread = PI * 0.100000f, .aim_against_vel = 1,
+    .shrink = 0.000000f, .shrink_rate = 12.300000f,
+    .begin_tint = { 255, 0, 0, 255 }, .end_tint = { 255, 0, 0, 216 },
+  },
+  [2] = {
+    .count_min = 200, .count_max = 210,
+    .lifetime_min = TARGET_FRAME_TIME * 20.000000f, .lifetime_max = TARGET_FRAME_TIME * 25.000000f,
+    .speed_min = 500.000000f, .speed_max = 600.000000f,
+    .radius_min = 2.700000f, .radius_max = 3.200000f,
+    .friction_min = 0.000000f, .friction_max = 2.000000f,
+    .spread = PI * 1.000000f, .aim_against_vel = 0,
+    .shrink = 0.700000f, .shrink_rate = 0.000000f,
+    .begin_tint = { 255, 0, 0, 255 }, .end_tint = { 255, 0, 0, 191 },
+  },
+  [3] = {
+    .count_min = 1100, .count_max = 1300,
+    .lifetime_min = TARGET_FRAME_TIME * 20.000000f, .lifetime_max = TARGET_FRAME_TIME * 30.000000f,
+    .speed_min = 400.000000f, .speed_max = 600.000000f,
+    .radius_min = 3.700000f, .radius_max = 4.600000f,
+    .friction_min = 0.000000f, .friction_max = 2.000000f,
+    .spread = PI * 1.000000f, .aim_against_vel = 0,
+    .shrink = 0.700000f, .shrink_rate = 0.000000f,
+    .begin_tint = { 255, 0, 0, 255 }, .end_tint = { 255, 0, 0, 191 },
+  },
+  [4] = {
+    .count_min = 10, .count_max = 15,
+    .lifetime_min = TARGET_FRAME_TIME * 30.000000f, .lifetime_max = TARGET_FRAME_TIME * 40.000000f,
+    .speed_min = 80.000000f, .speed_max = 90.000000f,
+    .radius_min = 2.900000f, .radius_max = 3.500000f,
+    .friction_min = 0.050000f, .friction_max = 0.100000f,
+    .spread = PI * 1.000000f, .aim_against_vel = 0,
+    .shrink = 0.360000f, .shrink_rate = 0.000000f,
+    .begin_tint = { 0, 255, 0, 255 }, .end_tint = { 0, 255, 0, 204 },
+  },
+  [5] = {
+    .count_min = 10, .count_max = 15,
+    .lifetime_min = TARGET_FRAME_TIME * 30.000000f, .lifetime_max = TARGET_FRAME_TIME * 40.000000f,
+    .speed_min = 80.000000f, .speed_max = 90.000000f,
+    .radius_min = 2.900000f, .radius_max = 3.500000f,
+    .friction_min = 0.050000f, .friction_max = 0.100000f,
+    .spread = PI * 1.000000f, .aim_against_vel = 0,
+    .shrink = 0.360000f, .shrink_rate = 0.000000f,
+    .begin_tint = { 102, 57, 49, 255 }, .end_tint = { 102, 57, 49, 204 },
+  },
+  [6] = {
+    .count_min = 10, .count_max = 15,
+    .lifetime_min = TARGET_FRAME_TIME * 30.000000f, .lifetime_max = TARGET_FRAME_TIME * 40.000000f,
+    .speed_min = 80.000000f, .speed_max = 90.000000f,
+    .radius_min = 0.900000f, .radius_max = 1.700000f,
+    .friction_min = 0.050000f, .friction_max = 0.100000f,
+    .spread = PI * 1.000000f, .aim_against_vel = 0,
+    .shrink = 0.460000f, .shrink_rate = 0.000000f,
+    .begin_tint = { 58, 58, 58, 255 }, .end_tint = { 58, 58, 58, 204 },
+  },
+  [7] = {
+    .count_min = 100, .count_max = 110,
+    .lifetime_min = TARGET_FRAME_TIME * 20.000000f, .lifetime_max = TARGET_FRAME_TIME * 26.000000f,
+    .speed_min = 1400.000000f, .speed_max = 1500.000000f,
+    .radius_min = 2.000000f, .radius_max = 4.000000f,
+    .friction_min = 8.000000f, .friction_max = 15.000000f,
+    .spread = PI * 1.000000f, .aim_against_vel = 0,
+    .shrink = 0.500000f, .shrink_rate = 0.000000f,
+    .begin_tint = { 245, 245, 245, 255 }, .end_tint = { 245, 245, 245, 204 },
+  },
+  [8] = {
+    .count_min = 300, .count_max = 320,
+    .lifetime_min = TARGET_FRAME_TIME * 20.000000f, .lifetime_max = TARGET_FRAME_TIME * 30.000000f,
+    .speed_min = 400.000000f, .speed_max = 700.000000f,
+    .radius_min = 2.900000f, .radius_max = 4.700000f,
+    .friction_min = 0.000000f, .friction_max = 2.000000f,
+    .spread = PI * 1.000000f, .aim_against_vel = 0,
+    .shrink = 0.600000f, .shrink_rate = 0.000000f,
+    .begin_tint = { 253, 249, 0, 255 }, .end_tint = { 255, 161, 0, 255 },
+  },
+  [9] = {
+    .count_min = 200, .count_max = 220,
+    .lifetime_min = TARGET_FRAME_TIME * 20.000000f, .lifetime_max = TARGET_FRAME_TIME * 30.000000f,
+    .speed_min = 400.000000f, .speed_max = 700.000000f,
+    .radius_min = 2.900000f, .radius_max = 4.700000f,
+    .friction_min = 0.000000f, .friction_max = 2.000000f,
+    .spread = PI * 1.000000f, .aim_against_vel = 0,
+    .shrink = 0.600000f, .shrink_rate = 0.000000f,
+    .begin_tint = { 255, 161, 0, 255 }, .end_tint = { 230, 41, 55, 255 },
+  },
+  [10] = {
+    .count_min = 40, .count_max = 60,
+    .lifetime_min = TARGET_FRAME_TIME * 20.000000f, .lifetime_max = TARGET_FRAME_TIME * 30.000000f,
+    .speed_min = 400.000000f, .speed_max = 700.000000f,
+    .radius_min = 2.900000f, .radius_max = 4.700000f,
+    .friction_min = 0.000000f, .friction_max = 2.000000f,
+    .spread = PI * 1.000000f, .aim_against_vel = 0,
+    .shrink = 0.600000f, .shrink_rate = 0.000000f,
+    .begin_tint = { 230, 41, 55, 255 }, .end_tint = { 230, 41, 55, 204 },
+  },
+};
+
+/* particle emitters */
+
+const Particle_emitter_def __particle_emitters[PARTICLE_EMITTER_MAX] =
+{
+  [PARTICLE_EMITTER_SPARKS] = { .first_burst = 0, .bursts_count = 1 },
+  [PARTICLE_EMITTER_BLOOD_SPIT] = { .first_burst = 1, .bursts_count = 1 },
+  [PARTICLE_EMITTER_BLOOD_PUFF] = { .first_burst = 2, .bursts_count = 1 },
+  [PARTICLE_EMITTER_MASSIVE_BLOOD_PUFF] = { .first_burst = 3, .bursts_count = 1 },
+  [PARTICLE_EMITTER_GREEN_PUFF] = { .first_burst = 4, .bursts_count = 1 },
+  [PARTICLE_EMITTER_BROWN_PUFF] = { .first_burst = 5, .bursts_count = 1 },
+  [PARTICLE_EMITTER_WEAPON_DIE_PUFF] = { .first_burst = 6, .bursts_count = 1 },
+  [PARTICLE_EMITTER_WHITE_PUFF] = { .first_burst = 7, .bursts_count = 1 },
+  [PARTICLE_EMITTER_BIG_PLANE_EXPLOSION] = { .first_burst = 8, .bursts_count = 3 },
+};
+
+
+/////////////////////////
+/// END GENERATED
+
@@ -0,0 +1,94 @@
+#ifndef JLIB_POOL_H
+#define JLIB_POOL_H
+
+#include "basic.h"
+#include "arena.h"
+
+/*
+ * Fixed size slots carved out of an arena, with a free list threaded through
+ * the freed slots so pool_free and the next push are O(1) and freed memory is
+ * reused instead of growing the arena. The pool doesn't own its arena, when
+ * the arena gets cleared the pool has to be cleared with it.
+ */
+
+typedef struct Pool_free_slot Pool_free_slot;
+struct Pool_free_slot {
+  Pool_free_slot *next;
+};
+
+typedef struct Pool Pool;
+struct Pool {
+  Arena *arena;
+  u64 stride;
+  u64 align;
+  Pool_free_slot *free_first;
+  s64 live_count;
+  s64 slots_count; // slots ever pushed onto the arena since the last clear
+};
+
+#define pool_init(pool, arena, T) pool_init_((pool), (arena), sizeof(T), MAX(8, align_of(T)))
+
+#define pool_push_no_zero(pool, T) (T*)pool_push_((pool), sizeof(T))
+#define pool_push(pool, T) (T*)memory_zero(pool_push_((pool), sizeof(T)), sizeof(T))
+
+void  pool_init_(Pool *pool, Arena *arena, u64 size, u64 align);
+void* pool_push_(Pool *pool, u64 size);
+void  pool_free(Pool *pool, void *ptr);
+void  pool_clear(Pool *pool);
+
+#endif
+
+#if defined(JLIB_POOL_IMPL) != defined(_UNITY_BUILD_)
+
+#ifdef _UNITY_BUILD_
+#define JLIB_POOL_IMPL
+#endif
+
+void pool_init_(Pool *pool, Arena *arena, u64 size, u64 align) {
+  ASSERT(arena);
+
+  pool->arena = arena;
+  pool->stride = ALIGN_UP(MAX(size, sizeof(Pool_free_slot)), align);
+  pool->align = align;
+  pool->free_first = 0;
+  pool->live_count = 0;
+  pool->slots_count = 0;
+}
+
+void* pool_push_(Pool *pool, u64 size) {
+  ASSERT(pool->arena);
+  ASSERT(size <= pool->stride);
+
+  void *result = pool->free_first;
+
+  if(result) {
+    pool->free_first = pool->free_first->next;
+  } else {
+    result = arena_push(pool->arena, pool->stride, pool->align);
+    pool->slots_count++;
+  }
+
+  pool->live_count++;
+
+  return result;
+}
+
+void pool_free(Pool *pool, void *ptr) {
+  if(!ptr) return;
+
+  ASSERT(pool->live_count > 0);
+
+  Pool_free_slot *slot = (Pool_free_slot*)ptr;
+  slot->next = pool->free_first;
+  pool->free_first = slot;
+
+  pool->live_count--;
+}
+
+void pool_clear(Pool *pool) {
+  pool->free_first = 0;
+  pool->live_count = 0;
+  pool->slots_count = 0;
+}
+
+#endif
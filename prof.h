@@ -0,0 +1,263 @@
+#ifndef JLIB_PROF_H
+#define JLIB_PROF_H
+
+#include "basic.h"
+#include "arena.h"
+#include "str.h"
+
+/*
+ * Frame zone profiler.
+ *
+ * PROF_ZONE("name") { ... } times the statement after it. Zones nest, and
+ * every zone between prof_frame_begin and prof_frame_end is kept in a ring of
+ * the last PROF_FRAMES frames. prof_chrome_trace turns the ring into Chrome
+ * trace event JSON for chrome://tracing or ui.perfetto.dev.
+ *
+ * PROF_ZONE is a defer_loop, leaving its statement with break, continue, goto
+ * or return skips the end of the zone. Where a region has to be left that way
+ * call prof_zone_begin and prof_zone_end by hand.
+ */
+
+#ifndef PROF_FRAMES
+#define PROF_FRAMES 128
+#endif
+
+#ifndef PROF_MAX_ZONES_PER_FRAME
+#define PROF_MAX_ZONES_PER_FRAME 512
+#endif
+
+#define PROF_MAX_DEPTH 32
+
+typedef struct Prof_zone Prof_zone;
+struct Prof_zone {
+  char *name; /* not copied, must outlive the ring, string literals or static tables */
+  u64   begin_ns;
+  u64   end_ns;
+  u32   depth;
+};
+
+typedef struct Prof_frame Prof_frame;
+struct Prof_frame {
+  u64 index;
+  u64 begin_ns;
+  u64 end_ns;
+  s32 zones_count;
+  s32 zones_dropped;
+  Prof_zone zones[PROF_MAX_ZONES_PER_FRAME];
+};
+
+typedef struct Prof Prof;
+struct Prof {
+  Prof_frame frames[PROF_FRAMES];
+  u64 frames_count; /* frames ended so far, the ring holds the last PROF_FRAMES of them */
+  b32 in_frame;
+  s32 depth;
+  s32 stack[PROF_MAX_DEPTH]; /* zone index of each open zone, -1 when it was dropped */
+};
+
+#ifdef PROF_DISABLE
+
+#define PROF_ZONE(name)
+
+force_inline void prof_frame_begin(void) {}
+force_inline void prof_frame_end(void) {}
+force_inline void prof_zone_begin(char *name) {}
+force_inline void prof_zone_end(void) {}
+force_inline Prof_frame* prof_frame_ago(u64 ago) { return 0; }
+force_inline Prof_frame* prof_last_frame(void) { return 0; }
+force_inline Str8 prof_chrome_trace(Arena *arena) { return (Str8){0}; }
+
+#else
+
+#define PROF_ZONE(name) defer_loop(prof_zone_begin(name), prof_zone_end())
+
+u64  prof_now_ns(void);
+
+void prof_frame_begin(void);
+void prof_frame_end(void);
+void prof_zone_begin(char *name);
+void prof_zone_end(void);
+
+Prof_frame* prof_frame_ago(u64 ago);
+Prof_frame* prof_last_frame(void);
+
+Str8 prof_chrome_trace(Arena *arena);
+
+#endif
+
+#endif
+
+#if defined(JLIB_PROF_IMPL) != defined(_UNITY_BUILD_)
+
+#ifdef _UNITY_BUILD_
+#define JLIB_PROF_IMPL
+#endif
+
+#ifndef PROF_DISABLE
+
+#if defined(OS_LINUX) || defined(OS_MAC) || defined(OS_WEB)
+
+#include <time.h>
+
+u64 prof_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+#elif defined(OS_WINDOWS)
+
+#error "windows support not implemented"
+
+#endif
+
+/* global so any file can open a zone without setup, about 2 MB */
+Prof prof_state;
+
+force_inline Prof_frame* prof_cur_frame(void) {
+  return &prof_state.frames[prof_state.frames_count % PROF_FRAMES];
+}
+
+void prof_frame_begin(void) {
+  Prof *prof = &prof_state;
+
+  ASSERT(!prof->in_frame);
+
+  Prof_frame *frame = prof_cur_frame();
+  frame->index = prof->frames_count;
+  frame->begin_ns = prof_now_ns();
+  frame->end_ns = frame->begin_ns;
+  frame->zones_count = 0;
+  frame->zones_dropped = 0;
+
+  prof->in_frame = 1;
+  prof->depth = 0;
+}
+
+void prof_frame_end(void) {
+  Prof *prof = &prof_state;
+
+  ASSERT(prof->in_frame);
+  ASSERT(prof->depth == 0);
+
+  prof_cur_frame()->end_ns = prof_now_ns();
+
+  prof->in_frame = 0;
+  prof->frames_count++;
+}
+
+void prof_zone_begin(char *name) {
+  Prof *prof = &prof_state;
+
+  /* zones outside a frame, like the ones game_init runs through, aren't recorded */
+  if(!prof->in_frame) return;
+
+  ASSERT(prof->depth < PROF_MAX_DEPTH);
+
+  Prof_frame *frame = prof_cur_frame();
+
+  if(frame->zones_count >= PROF_MAX_ZONES_PER_FRAME) {
+    frame->zones_dropped++;
+    prof->stack[prof->depth++] = -1;
+    return;
+  }
+
+  s32 zone_i = frame->zones_count++;
+  Prof_zone *zone = &frame->zones[zone_i];
+  zone->name = name;
+  zone->depth = (u32)prof->depth;
+  zone->begin_ns = prof_now_ns();
+  zone->end_ns = zone->begin_ns;
+
+  prof->stack[prof->depth++] = zone_i;
+}
+
+void prof_zone_end(void) {
+  Prof *prof = &prof_state;
+
+  if(!prof->in_frame) return;
+
+  ASSERT(prof->depth > 0);
+
+  s32 zone_i = prof->stack[--prof->depth];
+
+  if(zone_i >= 0) {
+    prof_cur_frame()->zones[zone_i].end_ns = prof_now_ns();
+  }
+}
+
+/*
+ * The frame that ended ago frames before the last one, 0 once that's out of the
+ * ring. Mid-frame the oldest slot already belongs to the frame in progress.
+ */
+Prof_frame* prof_frame_ago(u64 ago) {
+  Prof *prof = &prof_state;
+
+  if(ago >= PROF_FRAMES - (u64)prof->in_frame || ago >= prof->frames_count) return 0;
+
+  return &prof->frames[(prof->frames_count - 1 - ago) % PROF_FRAMES];
+}
+
+/* the last frame that ended, 0 before the first one */
+Prof_frame* prof_last_frame(void) {
+  return prof_frame_ago(0);
+}
+
+Str8 prof_chrome_trace(Arena *arena) {
+  Prof *prof = &prof_state;
+
+  Str8_list events = {0};
+
+  /* called mid-frame the slot of the oldest frame is being overwritten by the current one */
+  u64 kept = PROF_FRAMES - (u64)prof->in_frame;
+  u64 first = prof->frames_count > kept ? prof->frames_count - kept : 0;
+  u64 origin_ns = prof->frames_count > 0 ? prof->frames[first % PROF_FRAMES].begin_ns : 0;
+
+  for(u64 frame_i = first; frame_i < prof->frames_count; frame_i++) {
+    Prof_frame *frame = &prof->frames[frame_i % PROF_FRAMES];
+
+    /* complete events, ts and dur are in microseconds */
+    str8_list_append_string(arena, events,
+        push_str8f(arena, "%s{\"name\":\"frame %llu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"dropped zones\":%i}}",
+          events.count ? ",\n" : "",
+          (unsigned long long)frame->index,
+          (f64)(frame->begin_ns - origin_ns) * 1e-3,
+          (f64)(frame->end_ns - frame->begin_ns) * 1e-3,
+          frame->zones_dropped));
+
+    for(s32 zone_i = 0; zone_i < frame->zones_count; zone_i++) {
+      Prof_zone *zone = &frame->zones[zone_i];
+
+      str8_list_append_string(arena, events,
+          push_str8f(arena, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+            zone->name,
+            (f64)(zone->begin_ns - origin_ns) * 1e-3,
+            (f64)(zone->end_ns - zone->begin_ns) * 1e-3));
+    }
+  }
+
+  Str8 head = str8_lit("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  Str8 tail = str8_lit("\n]}\n");
+
+  Str8 result = { .len = head.len + events.total_len + tail.len };
+  result.s = push_array_no_zero(arena, u8, result.len + 1);
+
+  u8 *at = result.s;
+  memory_copy(at, head.s, head.len);
+  at += head.len;
+
+  for(Str8_node *node = events.first; node; node = node->next) {
+    memory_copy(at, node->str.s, node->str.len);
+    at += node->str.len;
+  }
+
+  memory_copy(at, tail.s, tail.len);
+  at += tail.len;
+  *at = 0;
+
+  return result;
+}
+
+#endif
+
+#endif
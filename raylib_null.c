@@ -0,0 +1,249 @@
+/*
+ * Null raylib backend for headless builds.
+ *
+ * Implements just the part of the raylib API the game calls, with no window,
+ * GL context or audio device behind it. Drawing and audio do nothing, input
+ * reads as idle, the screen is a fixed 1000x800 like the window game_init opens,
+ * and every frame is one sim tick long. The math, file and logging calls do the
+ * real thing so the simulation runs exactly as it does in the windowed build.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <time.h>
+
+
+#define NULL_SCREEN_WIDTH  1000
+#define NULL_SCREEN_HEIGHT 800
+
+
+/* window and timing */
+
+void InitWindow(int width, int height, const char *title) {}
+void CloseWindow(void) {}
+bool WindowShouldClose(void) { return false; }
+void SetConfigFlags(unsigned int flags) {}
+void SetTargetFPS(int fps) {}
+void SetExitKey(int key) {}
+void SetTraceLogLevel(int log_level) {}
+
+int GetScreenWidth(void)  { return NULL_SCREEN_WIDTH; }
+int GetScreenHeight(void) { return NULL_SCREEN_HEIGHT; }
+int GetRenderWidth(void)  { return NULL_SCREEN_WIDTH; }
+int GetRenderHeight(void) { return NULL_SCREEN_HEIGHT; }
+
+float GetFrameTime(void) { return TARGET_FRAME_TIME; }
+
+double GetTime(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void TraceLog(int log_level, const char *text, ...) {
+  if(log_level < LOG_INFO) return;
+
+  va_list args;
+  va_start(args, text);
+  vfprintf(stderr, text, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+void *MemAlloc(unsigned int size) { return calloc(size, 1); }
+void  MemFree(void *ptr) { free(ptr); }
+
+void SetRandomSeed(unsigned int seed) { srand(seed); }
+
+int GetRandomValue(int min, int max) {
+  if(min > max) {
+    int tmp = max;
+    max = min;
+    min = tmp;
+  }
+  return min + rand() % (max - min + 1);
+}
+
+
+/* files */
+
+unsigned char *LoadFileData(const char *file_name, int *data_size) {
+  *data_size = 0;
+
+  FILE *f = fopen(file_name, "rb");
+  if(!f) return 0;
+
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  unsigned char *data = malloc(size > 0 ? size : 1);
+  if(data && fread(data, 1, size, f) == (size_t)size) {
+    *data_size = (int)size;
+  } else {
+    free(data);
+    data = 0;
+  }
+
+  fclose(f);
+  return data;
+}
+
+void UnloadFileData(unsigned char *data) { free(data); }
+
+bool SaveFileData(const char *file_name, void *data, int data_size) {
+  FILE *f = fopen(file_name, "wb");
+  if(!f) return false;
+
+  bool ok = fwrite(data, 1, data_size, f) == (size_t)data_size;
+  fclose(f);
+  return ok;
+}
+
+
+/* input */
+
+bool IsKeyDown(int key) { return false; }
+bool IsKeyPressed(int key) { return false; }
+bool IsKeyReleased(int key) { return false; }
+int  PeekCharPressed(void) { return 0; }
+int  GetCharPressed(void) { return 0; }
+
+bool    IsMouseButtonDown(int button) { return false; }
+bool    IsMouseButtonPressed(int button) { return false; }
+bool    IsMouseButtonReleased(int button) { return false; }
+int     GetMouseX(void) { return NULL_SCREEN_WIDTH/2; }
+int     GetMouseY(void) { return NULL_SCREEN_HEIGHT/2; }
+Vector2 GetMousePosition(void) { return (Vector2){ NULL_SCREEN_WIDTH*0.5f, NULL_SCREEN_HEIGHT*0.5f }; }
+Vector2 GetMouseDelta(void) { return (Vector2){0}; }
+Vector2 GetMouseWheelMoveV(void) { return (Vector2){0}; }
+
+
+/* math the simulation depends on, same as rshapes.c, rcore.c and rtextures.c */
+
+bool CheckCollisionPointCircle(Vector2 point, Vector2 center, float radius) {
+  float dx = point.x - center.x;
+  float dy = point.y - center.y;
+  return dx*dx + dy*dy <= radius*radius;
+}
+
+bool CheckCollisionCircleRec(Vector2 center, float radius, Rectangle rec) {
+  float rec_center_x = rec.x + rec.width*0.5f;
+  float rec_center_y = rec.y + rec.height*0.5f;
+
+  float dx = fabsf(center.x - rec_center_x);
+  float dy = fabsf(center.y - rec_center_y);
+
+  if(dx > rec.width*0.5f + radius) return false;
+  if(dy > rec.height*0.5f + radius) return false;
+
+  if(dx <= rec.width*0.5f) return true;
+  if(dy <= rec.height*0.5f) return true;
+
+  float corner_x = dx - rec.width*0.5f;
+  float corner_y = dy - rec.height*0.5f;
+
+  return corner_x*corner_x + corner_y*corner_y <= radius*radius;
+}
+
+Vector2 GetScreenToWorld2D(Vector2 position, Camera2D camera) {
+  Matrix inv_cam = MatrixInvert(GetCameraMatrix2D(camera));
+  Vector3 transform = Vector3Transform((Vector3){ position.x, position.y, 0 }, inv_cam);
+  return (Vector2){ transform.x, transform.y };
+}
+
+Matrix GetCameraMatrix2D(Camera2D camera) {
+  Matrix origin = MatrixTranslate(-camera.target.x, -camera.target.y, 0.0f);
+  Matrix rotation = MatrixRotate((Vector3){ 0.0f, 0.0f, 1.0f }, camera.rotation*DEG2RAD);
+  Matrix scale = MatrixScale(camera.zoom, camera.zoom, 1.0f);
+  Matrix translation = MatrixTranslate(camera.offset.x, camera.offset.y, 0.0f);
+  return MatrixMultiply(MatrixMultiply(origin, MatrixMultiply(scale, rotation)), translation);
+}
+
+Vector2 GetMousePositionWorld2D(Camera2D camera) {
+  return GetScreenToWorld2D(GetMousePosition(), camera);
+}
+
+Color ColorAlpha(Color color, float alpha) {
+  alpha = Clamp(alpha, 0.0f, 1.0f);
+  color.a = (unsigned char)(255.0f*alpha);
+  return color;
+}
+
+Color ColorLerp(Color color1, Color color2, float factor) {
+  factor = Clamp(factor, 0.0f, 1.0f);
+  Color color = {
+    (unsigned char)((1.0f - factor)*color1.r + factor*color2.r),
+    (unsigned char)((1.0f - factor)*color1.g + factor*color2.g),
+    (unsigned char)((1.0f - factor)*color1.b + factor*color2.b),
+    (unsigned char)((1.0f - factor)*color1.a + factor*color2.a),
+  };
+  return color;
+}
+
+
+/* drawing */
+
+void BeginDrawing(void) {}
+void EndDrawing(void) {}
+void BeginMode2D(Camera2D camera) {}
+void EndMode2D(void) {}
+void ClearBackground(Color color) {}
+void rlDrawRenderBatchActive(void) {}
+void BeginScissorMode(int x, int y, int width, int height) {}
+void EndScissorMode(void) {}
+
+void DrawCircleV(Vector2 center, float radius, Color color) {}
+void DrawCircleLinesV(Vector2 center, float radius, Color color) {}
+void DrawLineEx(Vector2 start_pos, Vector2 end_pos, float thick, Color color) {}
+void DrawRectangleRec(Rectangle rec, Color color) {}
+void DrawRectangleLinesEx(Rectangle rec, float line_thick, Color color) {}
+void DrawGrid2D(int slices, float spacing) {}
+
+void DrawTexturePro(Texture2D texture, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint) {}
+void DrawTextureRec(Texture2D texture, Rectangle source, Vector2 position, Color tint) {}
+
+void    SetTextLineSpacing(int spacing) {}
+Font    GetFontDefault(void) { return (Font){ .baseSize = 10 }; }
+Vector2 MeasureTextEx(Font font, const char *text, float font_size, float spacing) { return (Vector2){0}; }
+void    DrawText(const char *text, int pos_x, int pos_y, int font_size, Color color) {}
+void    DrawTextEx(Font font, const char *text, Vector2 position, float font_size, float spacing, Color tint) {}
+
+Texture2D LoadTexture(const char *file_name) { return (Texture2D){0}; }
+Texture2D LoadTextureFromImage(Image image) { return (Texture2D){ .width = image.width, .height = image.height }; }
+void      UnloadTexture(Texture2D texture) {}
+void      UpdateTexture(Texture2D texture, const void *pixels) {}
+void      SetTextureFilter(Texture2D texture, int filter) {}
+
+void     UploadMesh(Mesh *mesh, bool dynamic) {}
+void     UpdateMeshBuffer(Mesh mesh, int index, const void *data, int data_size, int offset) {}
+void     DrawMesh(Mesh mesh, Material material, Matrix transform) {}
+void     UnloadMesh(Mesh mesh) {
+  MemFree(mesh.vertices);
+  MemFree(mesh.texcoords);
+  MemFree(mesh.colors);
+  MemFree(mesh.indices);
+}
+Material LoadMaterialDefault(void) { return (Material){0}; }
+void     UnloadMaterial(Material material) {}
+
+
+/* audio */
+
+void InitAudioDevice(void) {}
+void CloseAudioDevice(void) {}
+void SetMasterVolume(float volume) {}
+
+bool IsSoundValid(Sound sound) { return false; }
+void PlaySound(Sound sound) {}
+void SetSoundVolume(Sound sound, float volume) {}
+void SetSoundPitch(Sound sound, float pitch) {}
+void SetSoundPan(Sound sound, float pan) {}
+
+bool  IsMusicStreamPlaying(Music music) { return false; }
+void  PlayMusicStream(Music music) {}
+void  UpdateMusicStream(Music music) {}
+void  SeekMusicStream(Music music, float position) {}
+void  SetMusicVolume(Music music, float volume) {}
+float GetMusicTimePlayed(Music music) { return 0; }
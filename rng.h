@@ -0,0 +1,100 @@
+#ifndef JLIB_RNG_H
+#define JLIB_RNG_H
+
+#include "basic.h"
+
+/*
+ * PCG32 (XSH RR), see pcg-random.org.
+ * Every Rng is one independent stream: two Rngs seeded with the same seed but a
+ * different stream id never produce correlated sequences, so each system can
+ * own one without consuming numbers out from under the others.
+ */
+
+typedef struct Rng Rng;
+struct Rng {
+  u64 state;
+  u64 inc; /* stream selector, always odd */
+};
+
+#define RNG_MULTIPLIER 6364136223846793005ull
+
+void rng_seed(Rng *rng, u64 seed, u64 stream);
+
+force_inline u32 rng_u32(Rng *rng) {
+  u64 old = rng->state;
+  rng->state = old * RNG_MULTIPLIER + rng->inc;
+  u32 xorshifted = (u32)(((old >> 18u) ^ old) >> 27u);
+  u32 rot = (u32)(old >> 59u);
+  return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+/* uniform in [0, 1), the top 24 bits fill the mantissa exactly */
+force_inline f32 rng_f32(Rng *rng) {
+  return (f32)(rng_u32(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+force_inline f32 rng_range_f32(Rng *rng, f32 min, f32 max) {
+  return min + (max - min) * rng_f32(rng);
+}
+
+/* uniform in [min, max], inclusive on both ends like raylib's GetRandomValue */
+s32  rng_range_s32(Rng *rng, s32 min, s32 max);
+void rng_fill_f32(Rng *rng, f32 *dst, s64 n);
+
+#endif
+
+#if defined(JLIB_RNG_IMPL) != defined(_UNITY_BUILD_)
+
+#ifdef _UNITY_BUILD_
+#define JLIB_RNG_IMPL
+#endif
+
+
+void rng_seed(Rng *rng, u64 seed, u64 stream) {
+  rng->state = 0;
+  rng->inc = (stream << 1u) | 1u;
+  rng_u32(rng);
+  rng->state += seed;
+  rng_u32(rng);
+}
+
+s32 rng_range_s32(Rng *rng, s32 min, s32 max) {
+  if(min > max) {
+    s32 tmp = min;
+    min = max;
+    max = tmp;
+  }
+
+  u32 range = (u32)((s64)max - (s64)min) + 1u;
+
+  /* the full 32 bit range wraps to 0, any u32 is already uniform */
+  if(range == 0) return (s32)rng_u32(rng);
+
+  /* Lemire's multiply and reject, unbiased without a divide in the common case */
+  u64 m = (u64)rng_u32(rng) * (u64)range;
+  u32 low = (u32)m;
+
+  if(low < range) {
+    u32 threshold = (0u - range) % range;
+    while(low < threshold) {
+      m = (u64)rng_u32(rng) * (u64)range;
+      low = (u32)m;
+    }
+  }
+
+  return (s32)((s64)min + (s64)(m >> 32));
+}
+
+void rng_fill_f32(Rng *rng, f32 *dst, s64 n) {
+  /* a local copy of the state lets the compiler keep it in registers across the loop */
+  Rng r = *rng;
+
+  for(s64 i = 0; i < n; i++) {
+    dst[i] = rng_f32(&r);
+  }
+
+  *rng = r;
+}
+
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef JLIB_SIMD_H
+#define JLIB_SIMD_H
+
+#include "basic.h"
+
+/*
+ * 4 wide f32 lanes, just enough to write hot loops once for every target we ship.
+ * SSE2 and NEON are baseline on x64 and arm64, the web build needs -msimd128,
+ * anything else gets the scalar fallback.
+ */
+
+#define SIMD_WIDTH 4
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+# include <emmintrin.h>
+# define SIMD_SSE2 1
+
+typedef __m128 F32x4;
+
+#elif defined(__ARM_NEON)
+
+# include <arm_neon.h>
+# define SIMD_NEON 1
+
+typedef float32x4_t F32x4;
+
+#elif defined(__wasm_simd128__)
+
+# include <wasm_simd128.h>
+# define SIMD_WASM 1
+
+typedef v128_t F32x4;
+
+#else
+
+# define SIMD_SCALAR 1
+
+typedef struct F32x4 F32x4;
+struct F32x4 {
+  f32 e[4];
+};
+
+#endif
+
+
+/* loads and stores don't need alignment */
+
+force_inline F32x4 f32x4_load(f32 *p) {
+#if SIMD_SSE2
+  return _mm_loadu_ps(p);
+#elif SIMD_NEON
+  return vld1q_f32(p);
+#elif SIMD_WASM
+  return wasm_v128_load(p);
+#else
+  F32x4 r = {{ p[0], p[1], p[2], p[3] }};
+  return r;
+#endif
+}
+
+force_inline void f32x4_store(f32 *p, F32x4 a) {
+#if SIMD_SSE2
+  _mm_storeu_ps(p, a);
+#elif SIMD_NEON
+  vst1q_f32(p, a);
+#elif SIMD_WASM
+  wasm_v128_store(p, a);
+#else
+  p[0] = a.e[0]; p[1] = a.e[1]; p[2] = a.e[2]; p[3] = a.e[3];
+#endif
+}
+
+force_inline F32x4 f32x4_set1(f32 x) {
+#if SIMD_SSE2
+  return _mm_set1_ps(x);
+#elif SIMD_NEON
+  return vdupq_n_f32(x);
+#elif SIMD_WASM
+  return wasm_f32x4_splat(x);
+#else
+  F32x4 r = {{ x, x, x, x }};
+  return r;
+#endif
+}
+
+#if SIMD_SCALAR
+
+# define SIMD_SCALAR_OP(name, expr)                       \
+  force_inline F32x4 name(F32x4 a, F32x4 b) {             \
+    F32x4 r;                                              \
+    for(int i = 0; i < 4; i++) { f32 x = a.e[i], y = b.e[i]; r.e[i] = (expr); } \
+    return r;                                             \
+  }
+
+SIMD_SCALAR_OP(f32x4_add, x + y)
+SIMD_SCALAR_OP(f32x4_sub, x - y)
+SIMD_SCALAR_OP(f32x4_mul, x * y)
+SIMD_SCALAR_OP(f32x4_min, x < y ? x : y)
+SIMD_SCALAR_OP(f32x4_max, x > y ? x : y)
+
+# undef SIMD_SCALAR_OP
+
+#else
+
+force_inline F32x4 f32x4_add(F32x4 a, F32x4 b) {
+#if SIMD_SSE2
+  return _mm_add_ps(a, b);
+#elif SIMD_NEON
+  return vaddq_f32(a, b);
+#else
+  return wasm_f32x4_add(a, b);
+#endif
+}
+
+force_inline F32x4 f32x4_sub(F32x4 a, F32x4 b) {
+#if SIMD_SSE2
+  return _mm_sub_ps(a, b);
+#elif SIMD_NEON
+  return vsubq_f32(a, b);
+#else
+  return wasm_f32x4_sub(a, b);
+#endif
+}
+
+force_inline F32x4 f32x4_mul(F32x4 a, F32x4 b) {
+#if SIMD_SSE2
+  return _mm_mul_ps(a, b);
+#elif SIMD_NEON
+  return vmulq_f32(a, b);
+#else
+  return wasm_f32x4_mul(a, b);
+#endif
+}
+
+force_inline F32x4 f32x4_min(F32x4 a, F32x4 b) {
+#if SIMD_SSE2
+  return _mm_min_ps(a, b);
+#elif SIMD_NEON
+  return vminq_f32(a, b);
+#else
+  return wasm_f32x4_pmin(a, b);
+#endif
+}
+
+force_inline F32x4 f32x4_max(F32x4 a, F32x4 b) {
+#if SIMD_SSE2
+  return _mm_max_ps(a, b);
+#elif SIMD_NEON
+  return vmaxq_f32(a, b);
+#else
+  return wasm_f32x4_pmax(a, b);
+#endif
+}
+
+#endif
+
+
+/*
+ * Comparisons return lane masks, all bits set where true.
+ * Masks are kept in an F32x4 so they go straight into f32x4_select.
+ */
+
+force_inline F32x4 f32x4_cmp_lt(F32x4 a, F32x4 b) {
+#if SIMD_SSE2
+  return _mm_cmplt_ps(a, b);
+#elif SIMD_NEON
+  return vreinterpretq_f32_u32(vcltq_f32(a, b));
+#elif SIMD_WASM
+  return wasm_f32x4_lt(a, b);
+#else
+  F32x4 r;
+  for(int i = 0; i < 4; i++) { u32 m = a.e[i] < b.e[i] ? ~0u : 0u; memcpy(&r.e[i], &m, 4); }
+  return r;
+#endif
+}
+
+force_inline F32x4 f32x4_cmp_le(F32x4 a, F32x4 b) {
+#if SIMD_SSE2
+  return _mm_cmple_ps(a, b);
+#elif SIMD_NEON
+  return vreinterpretq_f32_u32(vcleq_f32(a, b));
+#elif SIMD_WASM
+  return wasm_f32x4_le(a, b);
+#else
+  F32x4 r;
+  for(int i = 0; i < 4; i++) { u32 m = a.e[i] <= b.e[i] ? ~0u : 0u; memcpy(&r.e[i], &m, 4); }
+  return r;
+#endif
+}
+
+force_inline F32x4 f32x4_and(F32x4 a, F32x4 b) {
+#if SIMD_SSE2
+  return _mm_and_ps(a, b);
+#elif SIMD_NEON
+  return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#elif SIMD_WASM
+  return wasm_v128_and(a, b);
+#else
+  F32x4 r;
+  for(int i = 0; i < 4; i++) { u32 x, y; memcpy(&x, &a.e[i], 4); memcpy(&y, &b.e[i], 4); x &= y; memcpy(&r.e[i], &x, 4); }
+  return r;
+#endif
+}
+
+/* mask ? a : b per lane */
+force_inline F32x4 f32x4_select(F32x4 mask, F32x4 a, F32x4 b) {
+#if SIMD_SSE2
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#elif SIMD_NEON
+  return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+#elif SIMD_WASM
+  return wasm_v128_bitselect(a, b, mask);
+#else
+  F32x4 r;
+  for(int i = 0; i < 4; i++) { u32 m; memcpy(&m, &mask.e[i], 4); r.e[i] = m ? a.e[i] : b.e[i]; }
+  return r;
+#endif
+}
+
+
+#endif